@@ -297,7 +297,7 @@ ffindex_index_t* ffindex_index_parse(FILE *index_file, size_t num_max_entries)
   if(index->index_data == MAP_FAILED)
     return NULL;
   index->type = SORTED_ARRAY; /* XXX Assume a sorted file for now */
-  int i = 0;
+  size_t i = 0;
   char* d = index->index_data;
   char* end;
   /* Faster than scanf per line */
@@ -4,9 +4,8 @@ Alignment::Alignment(std::string querySeqDB, std::string querySeqDBIndex,
         std::string targetSeqDB, std::string targetSeqDBIndex,
         std::string prefDB, std::string prefDBIndex, 
         std::string outDB, std::string outDBIndex,
-        std::string matrixFile, double evalThr, double covThr, int maxSeqLen, int seqType){
-
-    BUFFER_SIZE = 10000000;
+        std::string matrixFile, double evalThr, double covThr, int maxSeqLen, int seqType,
+        bool diagonalFilter){
 
     this->covThr = covThr;
 
@@ -36,6 +35,14 @@ Alignment::Alignment(std::string querySeqDB, std::string querySeqDBIndex,
     for (int i = 0; i < threads; i++)
         matchers[i] = new Matcher(m, maxSeqLen);
 
+    diagFilters = NULL;
+    if (diagonalFilter){
+        diagFilters = new DiagonalFilter*[threads];
+# pragma omp parallel for schedule(static)
+        for (int i = 0; i < threads; i++)
+            diagFilters[i] = new DiagonalFilter(m, maxSeqLen);
+    }
+
     // open the sequence, prefiltering and output databases
     qseqdbr = new DBReader(querySeqDB.c_str(), querySeqDBIndex.c_str());
     qseqdbr->open(DBReader::NOSORT);
@@ -49,15 +56,14 @@ Alignment::Alignment(std::string querySeqDB, std::string querySeqDBIndex,
     dbw = new DBWriter(outDB.c_str(), outDBIndex.c_str(), threads);
     dbw->open();
 
-    dbKeys = new char*[threads];
-# pragma omp parallel for schedule(static)
+    prefReaders = new PrefilterResultReader*[threads];
     for (int i = 0; i < threads; i++)
-        dbKeys[i] = new char[100];
+        prefReaders[i] = new PrefilterResultReader(tseqdbr);
 
-    outBuffers = new char*[threads];
+    outBuffers = new OutputBuffer*[threads];
 # pragma omp parallel for schedule(static)
     for (int i = 0; i < threads; i++)
-        outBuffers[i] = new char[BUFFER_SIZE];
+        outBuffers[i] = new OutputBuffer();
 
 }
 
@@ -66,14 +72,17 @@ Alignment::~Alignment(){
         delete qSeqs[i];
         delete dbSeqs[i];
         delete matchers[i];
-        delete[] dbKeys[i];
-        delete[] outBuffers[i];
+        if (diagFilters != NULL)
+            delete diagFilters[i];
+        delete prefReaders[i];
+        delete outBuffers[i];
     }
 
     delete[] qSeqs;
     delete[] dbSeqs;
     delete[] matchers;
-    delete[] dbKeys;
+    delete[] diagFilters;
+    delete[] prefReaders;
     delete[] outBuffers;
 
     delete m;
@@ -88,8 +97,9 @@ void Alignment::run (int maxAlnNum, int maxRejected){
 
     size_t alignmentsNum = 0;
     size_t passedNum = 0;
+    size_t filteredNum = 0;
 
-# pragma omp parallel for schedule(dynamic, 10) reduction (+: alignmentsNum, passedNum)
+# pragma omp parallel for schedule(dynamic, 10) reduction (+: alignmentsNum, passedNum, filteredNum)
     for (unsigned int id = 0; id < prefdbr->getSize(); id++){
         Log::printProgress(id);
 
@@ -105,36 +115,28 @@ void Alignment::run (int maxAlnNum, int maxRejected){
         char* querySeqData = qseqdbr->getDataByDBKey(queryDbKey);
         qSeqs[thread_idx]->mapSequence(id, queryDbKey, querySeqData);
         matchers[thread_idx]->initQuery(qSeqs[thread_idx]);
+        if (diagFilters != NULL)
+            diagFilters[thread_idx]->initQuery(qSeqs[thread_idx]);
 
-        // parse the prefiltering list and calculate a Smith-Waterman alignment for each sequence in the list 
+        // read the prefiltering list (text or binary) and calculate a Smith-Waterman alignment for each sequence in the list 
         std::list<Matcher::result_t>* swResults = new std::list<Matcher::result_t>();
-        std::stringstream lineSs (prefList);
-        std::string val;
+        PrefilterResultReader* prefReader = prefReaders[thread_idx];
+        prefReader->init(prefList, prefdbr->getDataSize(id));
 
         int rejected = 0;
         int cnt = 0;
-        while (std::getline(lineSs, val, '\t') && cnt < maxAlnNum && rejected < maxRejected){
-            // DB key of the db sequence
-            for (unsigned int j = 0; j < val.length(); j++)
-                dbKeys[thread_idx][j] = val.at(j);
-            dbKeys[thread_idx][val.length()] = '\0';
-            // prefiltering score
-            std::getline(lineSs, val, '\t');
-            //float prefScore = atof(val.c_str());
-            // prefiltering e-value
-            std::getline(lineSs, val, '\n');
-            //float prefEval = atof(val.c_str());
-
+        while (prefReader->next() && cnt < maxAlnNum && rejected < maxRejected){
             // map the database sequence
-            char* dbSeqData = tseqdbr->getDataByDBKey(dbKeys[thread_idx]);
+            char* dbKey = prefReader->getTargetKey();
+            char* dbSeqData = prefReader->getTargetData();
             if (dbSeqData == NULL){
 # pragma omp critical
                 {
-                    Debug(Debug::ERROR) << "ERROR: Sequence " << dbKeys[thread_idx] << " is required in the prefiltering, but is not contained in the input sequence database!\nPlease check your database.\n";
+                    Debug(Debug::ERROR) << "ERROR: Sequence " << dbKey << " is required in the prefiltering, but is not contained in the input sequence database!\nPlease check your database.\n";
                     exit(1);
                 }
             }
-            dbSeqs[thread_idx]->mapSequence(-1, dbKeys[thread_idx], dbSeqData);
+            dbSeqs[thread_idx]->mapSequence(-1, dbKey, dbSeqData);
 
             // check if the sequences could pass the coverage threshold 
             if ( (((float) qSeqs[thread_idx]->L) / ((float) dbSeqs[thread_idx]->L) < covThr) ||
@@ -143,6 +145,13 @@ void Alignment::run (int maxAlnNum, int maxRejected){
                 continue;
             }
 
+            // check for two word hits on a diagonal before the expensive alignment
+            if (diagFilters != NULL && !diagFilters[thread_idx]->passes(dbSeqs[thread_idx])){
+                filteredNum++;
+                rejected++;
+                continue;
+            }
+
             // calculate Smith-Waterman alignment
             Matcher::result_t res = matchers[thread_idx]->getSWResult(dbSeqs[thread_idx], tseqdbr->getSize(), evalThr);
 
@@ -162,31 +171,33 @@ void Alignment::run (int maxAlnNum, int maxRejected){
         // write the results
         swResults->sort(Matcher::compareHits);
         std::list<Matcher::result_t>::iterator it;
-        std::stringstream swResultsSs;
+        OutputBuffer* out = outBuffers[thread_idx];
+        out->clear();
 
         // put the contents of the swResults list into ffindex DB
         for (it = swResults->begin(); it != swResults->end(); ++it){
-                swResultsSs << it->dbKey << "\t";
-                swResultsSs << it->score << "\t";
-                swResultsSs << std::fixed << std::setprecision(3) << it->qcov << "\t";
-                swResultsSs << it->dbcov << "\t";
-                swResultsSs << it->seqId << "\t";
-                swResultsSs << std::scientific << it->eval << "\n";
+                out->appendString(it->dbKey.c_str(), it->dbKey.length());
+                out->appendChar('\t');
+                out->appendInt(it->score);
+                out->appendChar('\t');
+                out->appendFixed(it->qcov, 3);
+                out->appendChar('\t');
+                out->appendFixed(it->dbcov, 3);
+                out->appendChar('\t');
+                out->appendFixed(it->seqId, 3);
+                out->appendChar('\t');
+                out->appendScientific(it->eval, 3);
+                out->appendChar('\n');
        }
-        std::string swResultsString = swResultsSs.str();
-        const char* swResultsStringData = swResultsString.c_str();
-        if (BUFFER_SIZE <= swResultsString.length()){
-            Debug(Debug::ERROR) << "Output buffer size < result size! (" << BUFFER_SIZE << " <= " << swResultsString.length() << ")\nIncrease buffer size or reconsider your parameters - output buffer is already huge ;-)\n";
-            exit(1);
-        }
-        memcpy(outBuffers[thread_idx], swResultsStringData, swResultsString.length()*sizeof(char));
-        dbw->write(outBuffers[thread_idx], swResultsString.length(), qSeqs[thread_idx]->getDbKey(), thread_idx);
+        dbw->write(out->getData(), out->getLength(), qSeqs[thread_idx]->getDbKey(), thread_idx);
 
         delete swResults;
 
     }
     Debug(Debug::INFO) << "\n";
     Debug(Debug::INFO) << "All sequences processed.\n\n";
+    if (diagFilters != NULL)
+        Debug(Debug::INFO) << filteredNum << " sequence pairs removed by the diagonal filter.\n";
     Debug(Debug::INFO) << alignmentsNum << " alignments calculated.\n";
     Debug(Debug::INFO) << passedNum << " sequence pairs passed the thresholds (" << ((float)passedNum/(float)alignmentsNum) << " of overall calculated).\n";
     size_t hits = passedNum / prefdbr->getSize();
@@ -23,8 +23,11 @@ extern "C" {
 #include "../commons/SubstitutionMatrix.h"
 #include "../commons/Debug.h"
 #include "../commons/Log.h"
+#include "../commons/OutputBuffer.h"
+#include "../commons/PrefilterResultReader.h"
 
 #include "Matcher.h"
+#include "DiagonalFilter.h"
 
 class Alignment {
 
@@ -34,7 +37,8 @@ class Alignment {
                 std::string targetSeqDB, std::string targetSeqDBIndex,
                 std::string prefDB, std::string prefDBIndex,
                 std::string outDB, std::string outDBIndex,
-                std::string matrixFile, double evalThr, double covThr, int maxSeqLen, int seqType);
+                std::string matrixFile, double evalThr, double covThr, int maxSeqLen, int seqType,
+                bool diagonalFilter = false);
 
         ~Alignment();
 
@@ -44,8 +48,6 @@ class Alignment {
 
         int threads;
 
-        size_t BUFFER_SIZE;
-
         double covThr;
 
         double evalThr;
@@ -58,6 +60,9 @@ class Alignment {
 
         Matcher** matchers;
 
+        // two-hit diagonal filter before the Smith-Waterman alignment, NULL if switched off
+        DiagonalFilter** diagFilters;
+
         DBReader* qseqdbr;
 
         DBReader* tseqdbr;
@@ -66,11 +71,11 @@ class Alignment {
 
         DBWriter* dbw;
 
-        // buffers for the database keys (needed during the processing of the prefilterings lists)
-        char** dbKeys;
+        // readers of the prefiltering lists, one per thread
+        PrefilterResultReader** prefReaders;
 
         // output buffers
-        char** outBuffers;
+        OutputBuffer** outBuffers;
 
 };
 
@@ -0,0 +1,169 @@
+#include "DiagonalFilter.h"
+
+#include <cstring>
+#include <algorithm>
+
+DiagonalFilter::DiagonalFilter(BaseMatrix* m, int maxSeqLen, short wordThr, int window, short ungappedThr){
+    this->m = m;
+    this->alphabetSize = m->alphabetSize;
+    this->maxSeqLen = maxSeqLen;
+    this->wordThr = wordThr;
+    this->window = window;
+    this->ungappedThr = ungappedThr;
+    this->query = NULL;
+
+    wordsNum = 1;
+    for (int i = 0; i < WORD_SIZE; i++)
+        wordsNum *= alphabetSize;
+    wordStart = new unsigned int[wordsNum + 1];
+    memset(wordStart, 0, sizeof(unsigned int) * (wordsNum + 1));
+
+    // residues in the order of descending substitution score for each residue
+    sortedResidues = new int[alphabetSize * alphabetSize];
+    for (int x = 0; x < alphabetSize; x++){
+        std::vector<std::pair<short, int> > row;
+        for (int a = 0; a < alphabetSize; a++)
+            row.push_back(std::make_pair((short) -m->subMatrix[x][a], a));
+        std::sort(row.begin(), row.end());
+        for (int a = 0; a < alphabetSize; a++)
+            sortedResidues[x * alphabetSize + a] = row[a].second;
+    }
+
+    profileLen = maxSeqLen;
+    profile = new short[alphabetSize * profileLen];
+
+    // diagonal d = dbPos - queryPos + query length
+    lastHits = new DiagonalHit[2 * maxSeqLen + 1];
+    memset(lastHits, 0, sizeof(DiagonalHit) * (2 * maxSeqLen + 1));
+    currentStamp = 0;
+}
+
+DiagonalFilter::~DiagonalFilter(){
+    delete[] wordStart;
+    delete[] sortedResidues;
+    delete[] profile;
+    delete[] lastHits;
+}
+
+int DiagonalFilter::getWordIndex(const int* seq){
+    int idx = 0;
+    for (int i = 0; i < WORD_SIZE; i++)
+        idx = idx * alphabetSize + seq[i];
+    return idx;
+}
+
+void DiagonalFilter::initQuery(Sequence* query){
+    this->query = query;
+    const int L = query->L;
+    for (int a = 0; a < alphabetSize; a++){
+        for (int i = 0; i < L; i++)
+            profile[a * profileLen + i] = m->subMatrix[query->int_sequence[i]][a];
+    }
+
+    // collect the neighborhood words of all query positions and sort the positions by word (counting sort)
+    // the residues are enumerated by descending substitution score, the enumeration stops below the word threshold
+    std::vector<unsigned int> hitWords;
+    std::vector<unsigned short> hitPos;
+    for (int p = 0; p + WORD_SIZE <= L; p++){
+        const int* q = query->int_sequence + p;
+        const short* row0 = m->subMatrix[q[0]];
+        const short* row1 = m->subMatrix[q[1]];
+        const short* row2 = m->subMatrix[q[2]];
+        const int* res0 = sortedResidues + q[0] * alphabetSize;
+        const int* res1 = sortedResidues + q[1] * alphabetSize;
+        const int* res2 = sortedResidues + q[2] * alphabetSize;
+        const int rest2 = row2[res2[0]];
+        const int rest1 = row1[res1[0]] + rest2;
+        for (int ia = 0; ia < alphabetSize; ia++){
+            const int a = res0[ia];
+            const int s0 = row0[a];
+            if (s0 + rest1 < wordThr)
+                break;
+            for (int ib = 0; ib < alphabetSize; ib++){
+                const int b = res1[ib];
+                const int s1 = s0 + row1[b];
+                if (s1 + rest2 < wordThr)
+                    break;
+                for (int ic = 0; ic < alphabetSize; ic++){
+                    const int c = res2[ic];
+                    if (s1 + row2[c] < wordThr)
+                        break;
+                    hitWords.push_back((a * alphabetSize + b) * alphabetSize + c);
+                    hitPos.push_back(p);
+                }
+            }
+        }
+    }
+    memset(wordStart, 0, sizeof(unsigned int) * (wordsNum + 1));
+    for (size_t i = 0; i < hitWords.size(); i++)
+        wordStart[hitWords[i] + 1]++;
+    for (size_t w = 0; w < wordsNum; w++)
+        wordStart[w + 1] += wordStart[w];
+    wordPos.resize(hitWords.size());
+    // the positions of a word stay in ascending order
+    std::vector<unsigned int> fill(wordStart, wordStart + wordsNum);
+    for (size_t i = 0; i < hitWords.size(); i++)
+        wordPos[fill[hitWords[i]]++] = hitPos[i];
+}
+
+int DiagonalFilter::extendUngapped(Sequence* dbSeq, int qPos, int dbPos){
+    const int qL = query->L;
+    const int* dbSequence = dbSeq->int_sequence;
+    int score = 0;
+    for (int i = 0; i < WORD_SIZE; i++)
+        score += profile[dbSequence[dbPos + i] * profileLen + qPos + i];
+
+    // extension to the right, then to the left from the best right end
+    int best = score;
+    for (int i = qPos + WORD_SIZE, j = dbPos + WORD_SIZE; i < qL && j < dbSeq->L; i++, j++){
+        score += profile[dbSequence[j] * profileLen + i];
+        if (score > best)
+            best = score;
+        else if (best - score > X_DROP)
+            break;
+    }
+    score = best;
+    for (int i = qPos - 1, j = dbPos - 1; i >= 0 && j >= 0; i--, j--){
+        score += profile[dbSequence[j] * profileLen + i];
+        if (score > best)
+            best = score;
+        else if (best - score > X_DROP)
+            break;
+    }
+    return best;
+}
+
+bool DiagonalFilter::passes(Sequence* dbSeq){
+    const int qL = query->L;
+    const int dbL = dbSeq->L;
+    // too short for the word hits, the alignment decides
+    if (qL < WORD_SIZE || dbL < WORD_SIZE)
+        return true;
+
+    // a new stamp invalidates the hits of the previous DB sequence
+    currentStamp++;
+    if (currentStamp == 0){
+        memset(lastHits, 0, sizeof(DiagonalHit) * (2 * maxSeqLen + 1));
+        currentStamp = 1;
+    }
+
+    const int* dbSequence = dbSeq->int_sequence;
+    for (int j = 0; j + WORD_SIZE <= dbL; j++){
+        const int word = getWordIndex(dbSequence + j);
+        for (unsigned int k = wordStart[word]; k < wordStart[word + 1]; k++){
+            const int i = wordPos[k];
+            DiagonalHit& lastHit = lastHits[j - i + qL];
+            if (lastHit.stamp == currentStamp){
+                const int dist = j - lastHit.dbPos;
+                // overlapping hits do not count as a second hit
+                if (dist < WORD_SIZE)
+                    continue;
+                if (dist <= window && (ungappedThr == 0 || extendUngapped(dbSeq, i, j) >= ungappedThr))
+                    return true;
+            }
+            lastHit.stamp = currentStamp;
+            lastHit.dbPos = j;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,84 @@
+#ifndef DIAGONAL_FILTER_H
+#define DIAGONAL_FILTER_H
+
+//
+// Two-hit diagonal filter between the prefiltering and the Smith-Waterman alignment.
+// The query is indexed with all words of WORD_SIZE residues scoring at least wordThr against a query word (word neighborhood).
+// A DB sequence passes the filter if two non-overlapping word hits on the same diagonal are at most window residues apart
+// and the ungapped X-drop extension of the second hit reaches ungappedThr.
+// A DB sequence that does not pass the filter is very unlikely to have a significant Smith-Waterman alignment.
+//
+
+#include <vector>
+
+#include "../commons/Sequence.h"
+#include "../commons/BaseMatrix.h"
+
+class DiagonalFilter {
+
+    public:
+        // ungappedThr = 0: no ungapped extension, the two hits are sufficient
+        DiagonalFilter(BaseMatrix* m, int maxSeqLen, short wordThr = DEFAULT_WORD_THR, int window = DEFAULT_WINDOW, short ungappedThr = DEFAULT_UNGAPPED_THR);
+
+        ~DiagonalFilter();
+
+        // index the word neighborhood of the query
+        void initQuery(Sequence* query);
+
+        // true if the DB sequence has a two-hit diagonal (and a sufficient ungapped extension)
+        bool passes(Sequence* dbSeq);
+
+        static const int WORD_SIZE = 3;
+
+        // in the units of the substitution matrix (1/2 bit for the alignment)
+        static const short DEFAULT_WORD_THR = 12;
+
+        static const int DEFAULT_WINDOW = 40;
+
+        static const short DEFAULT_UNGAPPED_THR = 45;
+
+        // the ungapped extension stops when the score drops X_DROP below the best score
+        static const int X_DROP = 14;
+
+    private:
+        // score of the best ungapped extension through the word hit at the query position qPos and the DB position dbPos
+        int extendUngapped(Sequence* dbSeq, int qPos, int dbPos);
+
+        int getWordIndex(const int* seq);
+
+        BaseMatrix* m;
+
+        int alphabetSize;
+
+        int maxSeqLen;
+
+        short wordThr;
+
+        int window;
+
+        short ungappedThr;
+
+        Sequence* query;
+
+        // residues sorted by descending substitution score, alphabetSize entries for each residue
+        int* sortedResidues;
+
+        // query positions of the neighborhood words, the positions of word w are wordPos[wordStart[w]] ... wordPos[wordStart[w+1] - 1]
+        unsigned int* wordStart;
+        std::vector<unsigned short> wordPos;
+        size_t wordsNum;
+
+        // query profile: score of query position i against residue a at profile[a * profileLen + i]
+        short* profile;
+        int profileLen;
+
+        // last hit on each diagonal: DB position and the DB sequence counter at the time of the hit (no reset per DB sequence)
+        struct DiagonalHit {
+            int dbPos;
+            unsigned int stamp;
+        };
+        DiagonalHit* lastHits;
+        unsigned int currentStamp;
+};
+
+#endif
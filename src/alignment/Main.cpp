@@ -21,11 +21,12 @@ void printUsage(){
             "--max-rejected\t[int]\tMaximum rejected alignments before alignment calculation for a query is aborted. (default=INT_MAX)\n"
             "--nucleotides\t\tNucleotide sequences input.\n"
             "--sub-mat  \t[file]\tAmino acid substitution matrix file.\n"
+            "--diag-filter\t\tAlign only sequence pairs with two word hits on a diagonal and a sufficient ungapped extension score (faster).\n"
             "-v         \t[int]\tVerbosity level: 0=NOTHING, 1=ERROR, 2=WARNING, 3=INFO (default=3).\n");
     Debug(Debug::INFO) << usage;
 }
 
-void parseArgs(int argc, char** argv, std::string* qseqDB, std::string* tseqDB, std::string* prefDB, std::string* matrixFile, std::string* outDB, double* evalThr, double* covThr, int* maxSeqLen, int* maxAlnNum, int* seqType, int* verbosity, int* maxRejected, int* threads){
+void parseArgs(int argc, char** argv, std::string* qseqDB, std::string* tseqDB, std::string* prefDB, std::string* matrixFile, std::string* outDB, double* evalThr, double* covThr, int* maxSeqLen, int* maxAlnNum, int* seqType, int* verbosity, int* maxRejected, int* threads, bool* diagonalFilter){
     if (argc < 5){
         printUsage();
         exit(EXIT_FAILURE);
@@ -122,6 +123,10 @@ void parseArgs(int argc, char** argv, std::string* qseqDB, std::string* tseqDB,
                 exit(EXIT_FAILURE);
             }
         }
+        else if (strcmp(argv[i], "--diag-filter") == 0){
+            *diagonalFilter = true;
+            i++;
+        }
         else if (strcmp(argv[i], "--nucleotides") == 0){
             *seqType = Sequence::NUCLEOTIDES;
             i++;
@@ -199,6 +204,7 @@ int main(int argc, char **argv){
     int maxAlnNum = 300;
     int maxRejected = INT_MAX;
     int seqType = Sequence::AMINO_ACIDS;
+    bool diagonalFilter = false;
 
     // get the path of the scoring matrix
     char* mmdir = getenv ("MMDIR");
@@ -216,7 +222,7 @@ int main(int argc, char **argv){
         Debug(Debug::WARNING) << argv[i] << " ";
     Debug(Debug::WARNING) << "\n\n";
 
-    parseArgs(argc, argv, &qseqDB, &tseqDB, &prefDB, &matrixFile, &outDB, &evalThr, &covThr, &maxSeqLen, &maxAlnNum, &seqType, &verbosity, &maxRejected, &threads);
+    parseArgs(argc, argv, &qseqDB, &tseqDB, &prefDB, &matrixFile, &outDB, &evalThr, &covThr, &maxSeqLen, &maxAlnNum, &seqType, &verbosity, &maxRejected, &threads, &diagonalFilter);
 
 #ifdef OPENMP
     omp_set_num_threads(threads);
@@ -229,6 +235,7 @@ int main(int argc, char **argv){
         << "\nmin. sequence coverage:          \t" << covThr 
         << "\nmax. sequence length:            \t" << maxSeqLen 
         << "\nmax. alignment results per query:\t" << maxAlnNum 
+        << "\ndiagonal filter:                 \t" << (diagonalFilter ? "on" : "off") 
         << "\nmax rejected sequences per query:\t";
     if (maxRejected == INT_MAX)
         Debug(Debug::WARNING) << "off\n\n";
@@ -241,7 +248,7 @@ int main(int argc, char **argv){
     std::string outDBIndex = outDB+ ".index";
 
     Debug(Debug::WARNING) << "Init data structures...\n";
-    Alignment* aln = new Alignment(qseqDB, qseqDBIndex, tseqDB, tseqDBIndex, prefDB, prefDBIndex, outDB, outDBIndex, matrixFile, evalThr, covThr, maxSeqLen, seqType);
+    Alignment* aln = new Alignment(qseqDB, qseqDBIndex, tseqDB, tseqDBIndex, prefDB, prefDBIndex, outDB, outDBIndex, matrixFile, evalThr, covThr, maxSeqLen, seqType, diagonalFilter);
 
     Debug(Debug::WARNING) << "Calculation of Smith-Waterman alignments.\n";
     struct timeval start, end;
@@ -130,30 +130,21 @@ void Clustering::run(int mode){
 
 void Clustering::writeData(std::list<set *> ret){
 
-    size_t BUFFER_SIZE = 1000000;
-    char* outBuffer = new char[BUFFER_SIZE];
+    OutputBuffer res;
     std::list<set *>::const_iterator iterator;
     for (iterator = ret.begin(); iterator != ret.end(); ++iterator) {
-        std::stringstream res;
+        res.clear();
         set::element * element =(*iterator)->elements;
         // first entry is the representative sequence
         char* dbKey = seqDbr->getDbKey(element->element_id);
         do{
             char* nextDbKey = seqDbr->getDbKey(element->element_id);
-            res << nextDbKey << "\n";
+            res.appendString(nextDbKey);
+            res.appendChar('\n');
         }while((element=element->next)!=NULL);
 
-        std::string cluResultsOutString = res.str();
-        const char* cluResultsOutData = cluResultsOutString.c_str();
-        if (BUFFER_SIZE < strlen(cluResultsOutData)){
-            std::cerr << "Tried to process the clustering list for the query " << dbKey << " , length of the list = " << ret.size() << "\n";
-            std::cerr << "Output buffer size < clustering result size! (" << BUFFER_SIZE << " < " << cluResultsOutString.length() << ")\nIncrease buffer size or reconsider your parameters -> output buffer is already huge ;-)\n";
-            continue;
-        }
-        memcpy(outBuffer, cluResultsOutData, cluResultsOutString.length()*sizeof(char));
-        dbw->write(outBuffer, cluResultsOutString.length(), dbKey);
+        dbw->write(res.getData(), res.getLength(), dbKey);
     }
-    delete[] outBuffer;
 }
 
 
@@ -21,6 +21,7 @@
 #include "../commons/DBWriter.h"
 #include "../commons/Log.h"
 #include "../commons/Debug.h"
+#include "../commons/OutputBuffer.h"
 
 class Clustering {
 
@@ -21,7 +21,7 @@ DBReader::~DBReader(){
 void DBReader::open(int sort){
     // count the number of entries
     char line [1000];
-    int cnt = 0;
+    size_t cnt = 0;
     std::ifstream index_file(indexFileName);
     if (index_file.is_open()) {
         while ( index_file.getline (line, 1000) ){
@@ -63,7 +63,7 @@ void DBReader::open(int sort){
     // sort sequences by length and generate the corresponding id mappings
     id2local = new size_t[size];
     local2id = new size_t[size];
-    for (int i = 0; i < size; i++){
+    for (size_t i = 0; i < size; i++){
         id2local[i] = i;
         local2id[i] = i;
     }
@@ -114,6 +114,11 @@ char* DBReader::getData (size_t id){
     return data + (ffindex_get_entry_by_index(index, id)->offset);
 }
 
+size_t DBReader::getDataSize (size_t id){
+    const size_t length = ffindex_get_entry_by_index(index, getGlobalId(id))->length;
+    return (length > 0) ? length - 1 : 0;
+}
+
 char* DBReader::getDataByDBKey (char* key){
     checkClosed();
     return ffindex_get_data_by_name(data, index, key);
@@ -141,20 +146,30 @@ char* DBReader::getDbKey (size_t id){
     return &(ffindex_get_entry_by_index(index, id)->name[0]);
 }
 
+size_t DBReader::getGlobalId (size_t id){
+    checkClosed();
+    if (id >= size){
+        std::cerr << "Invalid database read for id=" << id << ", database index=" << indexFileName << "\n";
+        std::cerr << "getGlobalId: local id (" << id << ") >= db size (" << size << ")\n";
+        exit(EXIT_FAILURE);
+    }
+    return local2id[id];
+}
+
 size_t DBReader::getId (const char* dbKey){
     checkClosed();
-    int i = 0; 
-    int j = index->n_entries -1;
-    int k;
-    while (j >= i){
-        k = i + (j - i)/2;
+    // half-open search range [i, j), also for more than 2^31 entries and for an empty index
+    size_t i = 0;
+    size_t j = index->n_entries;
+    while (i < j){
+        size_t k = i + (j - i)/2;
         int cmp = strcmp(dbKey, index->entries[k].name);
         if (cmp == 0)
             return id2local[k];
         else if (cmp > 0)
             i = k + 1;
         else
-            j = k - 1;
+            j = k;
     }
     return UINT_MAX;
 }
@@ -164,6 +179,28 @@ unsigned short* DBReader::getSeqLens(){
     return seqLens;
 }
 
+void DBReader::setLocalIdOrder(const size_t* order){
+    checkClosed();
+    size_t* newLocal2id = new size_t[size];
+    // id2local is used to check that order is a permutation
+    for (size_t i = 0; i < size; i++)
+        id2local[i] = size;
+    for (size_t i = 0; i < size; i++){
+        if (order[i] >= size || id2local[local2id[order[i]]] != size){
+            std::cerr << "Invalid sequence order for database index=" << indexFileName << "\n";
+            exit(EXIT_FAILURE);
+        }
+        newLocal2id[i] = local2id[order[i]];
+        id2local[newLocal2id[i]] = i;
+    }
+    delete[] local2id;
+    local2id = newLocal2id;
+
+    for (size_t i = 0; i < size; i++){
+        seqLens[i] = (unsigned short)(ffindex_get_entry_by_index(index, local2id[i])->length);
+    }
+}
+
 void DBReader::merge(size_t* ids, size_t iLeft, size_t iRight, size_t iEnd, size_t* workspace)
 {
     size_t i0 = iLeft;
@@ -44,18 +44,28 @@ class DBReader {
 
         char* getData(size_t id);
 
+        // size of the data of the entry without the '\0' ffindex appends (binary entries can contain '\0')
+        size_t getDataSize(size_t id);
+
         char* getDataByDBKey(char* key);
 
         size_t getSize();
 
         char* getDbKey(size_t id);
 
+        // position of the entry in the ffindex index (sorted by the keys), equals the local id for NOSORT
+        size_t getGlobalId(size_t id);
+
         // does a binary search in the ffindex and returns index of the entry with dbKey
         // returns UINT_MAX if the key is not contained in index
         size_t getId (const char* dbKey);
 
         unsigned short* getSeqLens();
 
+        // renumbers the sequences: order[i] is the current local id of the sequence that gets the local id i
+        // used by the prefiltering to place sequences with similar k-mer content next to each other
+        void setLocalIdOrder(const size_t* order);
+
         static const int NOSORT = 0;
         static const int SORT = 1;
 
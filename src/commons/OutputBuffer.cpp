@@ -0,0 +1,229 @@
+#include "OutputBuffer.h"
+#include "Debug.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// the powers of ten up to 10^22 are exact doubles
+static const double POW10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+OutputBuffer::OutputBuffer(size_t capacity){
+    this->capacity = (capacity > 0) ? capacity : 1;
+    this->length = 0;
+    this->data = (char*) malloc(this->capacity);
+    if (data == NULL){
+        Debug(Debug::ERROR) << "Could not allocate " << this->capacity << " byte for the output buffer.\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+OutputBuffer::~OutputBuffer(){
+    free(data);
+}
+
+void OutputBuffer::grow(size_t minCapacity){
+    while (capacity < minCapacity)
+        capacity *= 2;
+    data = (char*) realloc(data, capacity);
+    if (data == NULL){
+        Debug(Debug::ERROR) << "Could not grow the output buffer to " << capacity << " byte.\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+void OutputBuffer::appendUInt(unsigned long long value){
+    char digits[20];
+    int len = 0;
+    do {
+        digits[len++] = '0' + (char) (value % 10);
+        value /= 10;
+    } while (value > 0);
+    reserve(len);
+    while (len > 0)
+        data[length++] = digits[--len];
+}
+
+void OutputBuffer::appendInt(long long value){
+    if (value < 0){
+        appendChar('-');
+        // -value overflows for the smallest long long
+        appendUInt(0ULL - (unsigned long long) value);
+    }
+    else
+        appendUInt((unsigned long long) value);
+}
+
+void OutputBuffer::appendDigits(unsigned long long value, int digits){
+    reserve(digits);
+    for (int i = digits - 1; i >= 0; i--){
+        data[length + i] = '0' + (char) (value % 10);
+        value /= 10;
+    }
+    length += digits;
+}
+
+void OutputBuffer::appendExponent(int exponent){
+    appendChar('e');
+    appendChar(exponent < 0 ? '-' : '+');
+    exponent = abs(exponent);
+    if (exponent < 10)
+        appendChar('0');
+    appendUInt(exponent);
+}
+
+bool OutputBuffer::special(double value){
+    // bit test instead of isnan/isinf, -ffast-math assumes finite values and flushes subnormal values to zero
+    unsigned long long bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const unsigned int exponent = (bits >> 52) & 0x7FF;
+    return exponent == 0x7FF || (exponent == 0 && (bits & 0xFFFFFFFFFFFFFULL) != 0);
+}
+
+void OutputBuffer::appendPrintf(const char* format, int precision, double value){
+    char str[400];
+    appendString(str, snprintf(str, sizeof(str), format, precision, value));
+}
+
+bool OutputBuffer::negative(double value){
+    // the sign bit, also for -0.0
+    unsigned long long bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits >> 63) != 0;
+}
+
+double OutputBuffer::scale(double value, int exponent){
+    while (exponent > 22){
+        value *= POW10[22];
+        exponent -= 22;
+    }
+    while (exponent < -22){
+        value /= POW10[22];
+        exponent += 22;
+    }
+    // one correctly rounded operation: exactly representable results (e.g. ties) stay exact
+    return (exponent >= 0) ? value * POW10[exponent] : value / POW10[-exponent];
+}
+
+unsigned long long OutputBuffer::roundDigits(double value, int digits, int* exponent){
+    const double upper = POW10[digits];
+    const double lower = POW10[digits - 1];
+    int e = (int) floor(log10(value));
+    // nearbyint rounds ties to even like printf
+    double rounded = nearbyint(scale(value, digits - 1 - e));
+    // log10 can be off by one next to the powers of ten, the rounding can carry into the next digit
+    if (rounded >= upper){
+        e++;
+        rounded = nearbyint(scale(value, digits - 1 - e));
+    }
+    else if (rounded < lower){
+        e--;
+        rounded = nearbyint(scale(value, digits - 1 - e));
+        if (rounded >= upper){
+            e++;
+            rounded = lower;
+        }
+    }
+    *exponent = e;
+    return (unsigned long long) rounded;
+}
+
+void OutputBuffer::appendFloat(double value, int precision){
+    if (precision < 1)
+        precision = 1;
+    if (precision > 15 || special(value)){
+        appendPrintf("%.*g", precision, value);
+        return;
+    }
+    if (negative(value)){
+        appendChar('-');
+        value = -value;
+    }
+    if (value == 0.0){
+        appendChar('0');
+        return;
+    }
+    int exponent;
+    unsigned long long digits = roundDigits(value, precision, &exponent);
+    // %g removes the trailing zeros
+    int significant = precision;
+    while (significant > 1 && digits % 10 == 0){
+        digits /= 10;
+        significant--;
+    }
+
+    char str[20];
+    for (int i = significant - 1; i >= 0; i--){
+        str[i] = '0' + (char) (digits % 10);
+        digits /= 10;
+    }
+    if (exponent < -4 || exponent >= precision){
+        appendChar(str[0]);
+        if (significant > 1){
+            appendChar('.');
+            appendString(str + 1, significant - 1);
+        }
+        appendExponent(exponent);
+    }
+    else if (exponent < 0){
+        appendString("0.", 2);
+        for (int i = 0; i < -exponent - 1; i++)
+            appendChar('0');
+        appendString(str, significant);
+    }
+    else if (significant <= exponent + 1){
+        appendString(str, significant);
+        for (int i = significant; i <= exponent; i++)
+            appendChar('0');
+    }
+    else {
+        appendString(str, exponent + 1);
+        appendChar('.');
+        appendString(str + exponent + 1, significant - exponent - 1);
+    }
+}
+
+void OutputBuffer::appendFixed(double value, int decimals){
+    if (decimals < 0 || decimals > 15 || special(value)){
+        appendPrintf("%.*f", decimals, value);
+        return;
+    }
+    const double scaled = scale(fabs(value), decimals);
+    // the rounding to integers is exact below 2^53
+    if (scaled >= 1e15){
+        appendPrintf("%.*f", decimals, value);
+        return;
+    }
+    if (negative(value))
+        appendChar('-');
+    const unsigned long long rounded = (unsigned long long) nearbyint(scaled);
+    const unsigned long long divisor = (unsigned long long) POW10[decimals];
+    appendUInt(rounded / divisor);
+    if (decimals > 0){
+        appendChar('.');
+        appendDigits(rounded % divisor, decimals);
+    }
+}
+
+void OutputBuffer::appendScientific(double value, int decimals){
+    if (decimals < 0 || decimals > 14 || special(value)){
+        appendPrintf("%.*e", decimals, value);
+        return;
+    }
+    if (negative(value)){
+        appendChar('-');
+        value = -value;
+    }
+    int exponent = 0;
+    unsigned long long digits = 0;
+    if (value != 0.0)
+        digits = roundDigits(value, decimals + 1, &exponent);
+    const unsigned long long divisor = (unsigned long long) POW10[decimals];
+    appendChar('0' + (char) (digits / divisor));
+    if (decimals > 0){
+        appendChar('.');
+        appendDigits(digits % divisor, decimals);
+    }
+    appendExponent(exponent);
+}
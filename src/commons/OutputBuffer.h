@@ -0,0 +1,99 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+//
+// Append-only character buffer for the result lists written to the ffindex databases.
+//
+// Numbers are converted without iostreams and without the locale, the output equals the printf conversions
+// named at the methods. Ties (e.g. 0.0625 with 3 decimals) are rounded half to even like printf, only a double value
+// within about 1e-16 (relative) of a tie may be rounded the other way (never for float values).
+// inf, nan, subnormal values and precisions above 15 digits are converted with snprintf.
+// The buffer grows when it is full, clear() keeps the memory for the next result list.
+//
+
+#include <cstddef>
+#include <cstring>
+
+class OutputBuffer {
+
+    public:
+
+        OutputBuffer(size_t capacity = 4096);
+
+        ~OutputBuffer();
+
+        // starts the next result list, keeps the memory
+        void clear() { length = 0; }
+
+        // the data is not NUL terminated
+        char* getData() { return data; }
+
+        size_t getLength() { return length; }
+
+        void appendChar(char c){
+            reserve(1);
+            data[length++] = c;
+        }
+
+        void appendString(const char* str){
+            appendString(str, strlen(str));
+        }
+
+        void appendString(const char* str, size_t len){
+            reserve(len);
+            memcpy(data + length, str, len);
+            length += len;
+        }
+
+        // %llu
+        void appendUInt(unsigned long long value);
+
+        // %lld
+        void appendInt(long long value);
+
+        // %.<precision>g, the default format of iostreams for precision 6
+        void appendFloat(double value, int precision = 6);
+
+        // %.<decimals>f (std::fixed)
+        void appendFixed(double value, int decimals);
+
+        // %.<decimals>e (std::scientific)
+        void appendScientific(double value, int decimals);
+
+    private:
+
+        char* data;
+
+        size_t length;
+
+        size_t capacity;
+
+        void reserve(size_t len){
+            if (length + len > capacity)
+                grow(length + len);
+        }
+
+        void grow(size_t minCapacity);
+
+        // infinite, nan and subnormal values are converted with snprintf
+        static bool special(double value);
+
+        void appendPrintf(const char* format, int precision, double value);
+
+        static bool negative(double value);
+
+        // rounds the positive value to digits significant digits, returns them as an integer
+        // and the decimal exponent of the first digit in exponent
+        static unsigned long long roundDigits(double value, int digits, int* exponent);
+
+        // value * 10^exponent
+        static double scale(double value, int exponent);
+
+        // writes the digits digits of value (with leading zeros)
+        void appendDigits(unsigned long long value, int digits);
+
+        // e+XX or e-XX, at least two exponent digits
+        void appendExponent(int exponent);
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef PREFILTER_FORMAT_H
+#define PREFILTER_FORMAT_H
+
+//
+// Binary format of the prefiltering result lists (mmseqs_pref --binary-output).
+//
+// A list starts with a header: a '\0' byte (text readers see an empty list), the letters "PRB" and the number
+// of entries in the target database, followed by one packed record of 10 byte per hit in the order of the text format.
+// The target sequence is given by its position in the ffindex index of the target database (sorted by the keys),
+// which is its id in a DBReader opened with DBReader::NOSORT (see DBReader::getGlobalId).
+// Both numbers are 32-bit, mmseqs_pref rejects --binary-output for target databases with more than UINT_MAX sequences.
+//
+// The text format has one line "targetKey\tzScore\tprefScore\n" per hit.
+// PrefilterResultReader reads both formats, pref2text converts binary results into the text format.
+//
+
+#include <cstring>
+
+#include "OutputBuffer.h"
+
+class PrefilterFormat {
+
+    public:
+
+        typedef struct {
+            char magic[4];
+            unsigned int targetDbSize;
+        } header_t;
+
+        typedef struct __attribute__((packed)) {
+            unsigned int targetId;
+            float zScore;
+            unsigned short prefScore;
+        } record_t;
+
+        static void appendHeader(OutputBuffer* out, size_t targetDbSize){
+            header_t header;
+            memcpy(header.magic, magic(), sizeof(header.magic));
+            header.targetDbSize = (unsigned int) targetDbSize;
+            out->appendString((const char*) &header, sizeof(header_t));
+        }
+
+        static void appendRecord(OutputBuffer* out, unsigned int targetId, float zScore, unsigned short prefScore){
+            record_t record;
+            record.targetId = targetId;
+            record.zScore = zScore;
+            record.prefScore = prefScore;
+            out->appendString((const char*) &record, sizeof(record_t));
+        }
+
+        // data: a result list of size byte (see DBReader::getDataSize)
+        static bool isBinary(const char* data, size_t size){
+            return size >= sizeof(header_t) && memcmp(data, magic(), 4) == 0;
+        }
+
+    private:
+
+        // the first 4 byte of a binary list
+        static const char* magic() { return "\0PRB"; }
+};
+
+#endif
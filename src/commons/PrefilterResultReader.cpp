@@ -0,0 +1,109 @@
+#include "PrefilterResultReader.h"
+#include "PrefilterFormat.h"
+#include "Debug.h"
+
+#include <cstdlib>
+#include <algorithm>
+
+PrefilterResultReader::PrefilterResultReader(DBReader* targetDbr) : zScoreText(32){
+    this->targetDbr = targetDbr;
+    this->binary = false;
+    this->pos = NULL;
+    this->end = NULL;
+    this->hit = NULL;
+    this->hitLength = 0;
+    this->targetId = 0;
+    this->key[0] = '\0';
+    this->zScore = 0.0f;
+    this->prefScore = 0;
+    this->printedZscore = 0.0f;
+    this->hasPrintedZscore = false;
+}
+
+void PrefilterResultReader::init(char* data, size_t size){
+    binary = PrefilterFormat::isBinary(data, size);
+    pos = data;
+    end = data + size;
+    if (binary){
+        PrefilterFormat::header_t header;
+        memcpy(&header, data, sizeof(header));
+        if (targetDbr != NULL && header.targetDbSize != targetDbr->getSize()){
+            Debug(Debug::ERROR) << "The prefiltering results were calculated for a target database with " << header.targetDbSize
+                << " sequences, the target database " << targetDbr->getDataFileName() << " has " << targetDbr->getSize() << " sequences.\n";
+            exit(EXIT_FAILURE);
+        }
+        pos += sizeof(header);
+    }
+}
+
+bool PrefilterResultReader::next(){
+    hasPrintedZscore = false;
+    if (binary){
+        if (pos + sizeof(PrefilterFormat::record_t) > end)
+            return false;
+        PrefilterFormat::record_t record;
+        memcpy(&record, pos, sizeof(record));
+        hit = pos;
+        hitLength = sizeof(record);
+        pos += sizeof(record);
+        if (targetDbr != NULL && record.targetId >= targetDbr->getSize()){
+            Debug(Debug::ERROR) << "Invalid target id " << record.targetId << " in a binary prefiltering result list.\n";
+            exit(EXIT_FAILURE);
+        }
+        targetId = record.targetId;
+        zScore = record.zScore;
+        prefScore = record.prefScore;
+        return true;
+    }
+
+    // text line: targetKey\tzScore\tprefScore\n
+    if (pos >= end || *pos == '\0')
+        return false;
+    char* keyEnd = pos;
+    while (keyEnd < end && *keyEnd != '\t' && *keyEnd != '\n')
+        keyEnd++;
+    const size_t keyLength = keyEnd - pos;
+    if (keyLength >= FFINDEX_MAX_ENTRY_NAME_LENTH){
+        Debug(Debug::ERROR) << "Too long target key in a prefiltering result list: " << std::string(pos, keyLength) << "\n";
+        exit(EXIT_FAILURE);
+    }
+    memcpy(key, pos, keyLength);
+    key[keyLength] = '\0';
+    hit = pos;
+    zScore = 0.0f;
+    prefScore = 0;
+    pos = keyEnd;
+    if (pos < end && *pos == '\t'){
+        zScore = strtof(pos + 1, &pos);
+        if (pos < end && *pos == '\t')
+            prefScore = (unsigned short) strtoul(pos + 1, &pos, 10);
+    }
+    // skip the rest of the line
+    while (pos < end && *pos != '\n')
+        pos++;
+    pos++;
+    hitLength = std::min(pos, end) - hit;
+    return true;
+}
+
+char* PrefilterResultReader::getTargetKey(){
+    return binary ? targetDbr->getDbKey(targetId) : key;
+}
+
+char* PrefilterResultReader::getTargetData(){
+    return binary ? targetDbr->getData(targetId) : targetDbr->getDataByDBKey(key);
+}
+
+float PrefilterResultReader::getPrintedZscore(){
+    // text hits are parsed from the printed z-score
+    if (!binary)
+        return zScore;
+    if (!hasPrintedZscore){
+        zScoreText.clear();
+        zScoreText.appendFloat(zScore);
+        zScoreText.appendChar('\0');
+        printedZscore = strtof(zScoreText.getData(), NULL);
+        hasPrintedZscore = true;
+    }
+    return printedZscore;
+}
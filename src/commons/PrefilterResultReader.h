@@ -0,0 +1,79 @@
+#ifndef PREFILTER_RESULT_READER_H
+#define PREFILTER_RESULT_READER_H
+
+//
+// Reads the hits of a prefiltering result list in the text or in the binary format (see PrefilterFormat).
+// Binary hits are read without parsing and give the target sequence without a key lookup,
+// text hits are parsed in place without copying the list.
+//
+
+#include "DBReader.h"
+#include "OutputBuffer.h"
+
+class PrefilterResultReader {
+
+    public:
+
+        // targetDbr: the target sequence database of the prefiltering, opened with DBReader::NOSORT
+        // (NULL: the hits are only copied with getHit, the target ids of binary lists are not checked)
+        PrefilterResultReader(DBReader* targetDbr);
+
+        // starts reading a result list of size byte (DBReader::getData and DBReader::getDataSize)
+        void init(char* data, size_t size);
+
+        // moves to the next hit, returns false at the end of the list
+        bool next();
+
+        bool isBinary() { return binary; }
+
+        // key of the target sequence of the current hit, valid until the next call of next()
+        char* getTargetKey();
+
+        // data of the target sequence of the current hit, NULL if the key is not in the target database
+        char* getTargetData();
+
+        float getZscore() { return zScore; }
+
+        // z-score at the precision of the text format (OutputBuffer::appendFloat), the same for a hit in both formats
+        float getPrintedZscore();
+
+        unsigned short getPrefScore() { return prefScore; }
+
+        // the current hit as stored in the list (a text line or a binary record), to copy it into a list of the same format
+        char* getHit() { return hit; }
+
+        size_t getHitLength() { return hitLength; }
+
+    private:
+
+        DBReader* targetDbr;
+
+        bool binary;
+
+        // unread part of the list
+        char* pos;
+
+        char* end;
+
+        char* hit;
+
+        size_t hitLength;
+
+        // current hit, the target id is set for binary lists only
+        size_t targetId;
+
+        char key[FFINDEX_MAX_ENTRY_NAME_LENTH];
+
+        float zScore;
+
+        unsigned short prefScore;
+
+        // z-score of a binary hit printed and parsed again, computed on the first call of getPrintedZscore
+        float printedZscore;
+
+        bool hasPrintedZscore;
+
+        OutputBuffer zScoreText;
+};
+
+#endif
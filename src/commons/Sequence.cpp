@@ -17,7 +17,7 @@ Sequence::~Sequence()
     delete stats;
 }
 
-void Sequence::mapSequence(int id, char* dbKey, const char * sequence){
+void Sequence::mapSequence(size_t id, char* dbKey, const char * sequence){
     this->id = id;
     this->dbKey = dbKey;
     if (this->seqType == Sequence::AMINO_ACIDS)
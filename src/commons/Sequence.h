@@ -26,7 +26,7 @@ class Sequence
         ~Sequence();
 
         // Map char -> int
-        void mapSequence(int id, char* dbKey, const char *seq);
+        void mapSequence(size_t id, char* dbKey, const char *seq);
 
         // checks if there is still a k-mer left 
         bool hasNextKmer(int kmerSize);
@@ -39,7 +39,7 @@ class Sequence
 
         void print(); // for debugging 
 
-        int getId() { return id; }
+        size_t getId() { return id; }
 
         char* getDbKey() { return dbKey; }
 
@@ -63,7 +63,7 @@ class Sequence
         void mapProteinSequence(const char *seq);
         void mapNucleotideSequence(const char *seq);
         
-        int id;
+        size_t id;
         char* dbKey;
         // current iterator position
         int currItPos;
@@ -0,0 +1,90 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+//
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+//
+// The items are kept in a ring buffer, the producer only writes the tail and the consumer only writes the head.
+// The full memory barrier before moving the head or the tail makes the item visible before the slot is handed over.
+// push and pop never block, waitPush and waitPop retry with idle() until they succeed.
+//
+
+#include <cstddef>
+#include <sched.h>
+#include <unistd.h>
+
+template <class T>
+class SpscQueue {
+
+    public:
+
+        // capacity: maximum number of items in the queue
+        SpscQueue(size_t capacity){
+            this->size = capacity + 1;
+            this->items = new T[size];
+            this->head = 0;
+            this->tail = 0;
+        }
+
+        ~SpscQueue(){
+            delete[] items;
+        }
+
+        // producer: returns false if the queue is full
+        bool push(const T& item){
+            const size_t t = tail;
+            const size_t next = (t + 1 == size) ? 0 : t + 1;
+            if (next == head)
+                return false;
+            items[t] = item;
+            __sync_synchronize();
+            tail = next;
+            return true;
+        }
+
+        // consumer: returns false if the queue is empty
+        bool pop(T* item){
+            const size_t h = head;
+            if (h == tail)
+                return false;
+            __sync_synchronize();
+            *item = items[h];
+            __sync_synchronize();
+            head = (h + 1 == size) ? 0 : h + 1;
+            return true;
+        }
+
+        void waitPush(const T& item){
+            for (int rounds = 0; !push(item); rounds++)
+                idle(rounds);
+        }
+
+        void waitPop(T* item){
+            for (int rounds = 0; !pop(item); rounds++)
+                idle(rounds);
+        }
+
+        // backoff of a thread waiting for a queue for the rounds-th time:
+        // yields the core at first and sleeps when the wait takes longer, so waiting threads do not keep a core busy
+        static void idle(int rounds){
+            if (rounds < 64)
+                sched_yield();
+            else
+                usleep(100);
+        }
+
+    private:
+
+        T* items;
+
+        size_t size;
+
+        // head and tail are on different cache lines, so the producer and the consumer do not invalidate each other's line
+        volatile size_t head;
+
+        char padding[64];
+
+        volatile size_t tail;
+};
+
+#endif
@@ -9,3 +9,12 @@ void * Util::mem_align(size_t boundary, size_t size) {
    }
    return pointer;
 }
+
+unsigned int Util::fnvHash(const void * data, size_t len, unsigned int hash) {
+  const unsigned char * p = (const unsigned char *) data;
+  for (size_t i = 0; i < len; i++) {
+	hash ^= p[i];
+	hash *= 16777619U;
+  }
+  return hash;
+}
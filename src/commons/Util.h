@@ -4,5 +4,7 @@
 class Util {
 public:
 	static void * mem_align(size_t bound, size_t size);
+	// FNV-1a hash, e.g. for fingerprints of the data an index was built from
+	static unsigned int fnvHash(const void * data, size_t len, unsigned int hash = 2166136261U);
 };
 #endif
@@ -6,6 +6,8 @@
 #include <math.h>
 
 #include <stdlib.h>
+#include <climits>
+#include <cstring>
 
 struct sort_by_score {
     bool operator()(const std::pair<short,unsigned int> left, const std::pair<short,unsigned int> right) {
@@ -21,35 +23,64 @@ ExtendedSubstitutionMatrix::ExtendedSubstitutionMatrix(short ** subMatrix,
     this->size = pow(alphabetSize, kmerSize);
     // create permutation 
     std::vector<std::vector<int> > input(buildInput(kmerSize,alphabetSize));
-    this->scoreMatrix = (std::pair<short,unsigned int> **) new std::pair<short,unsigned int> *[this->size];
+    this->score = new short *[this->size];
+    this->index = new unsigned int *[this->size];
     for(size_t i = 0; i < this->size;i++){
-        this->scoreMatrix[i]=(std::pair<short,unsigned int> *) new std::pair<short,unsigned int> [this->size];
+        this->score[i] = new short[this->size + ROW_PADDING];
+        this->index[i] = new unsigned int[this->size + ROW_PADDING];
+        memset(this->score[i] + this->size, 0, ROW_PADDING * sizeof(short));
+        memset(this->index[i] + this->size, 0, ROW_PADDING * sizeof(unsigned int));
     }
     std::vector<std::vector<int> > permutation;
     std::vector<int> outputTemp;
     createCartesianProduct(permutation, outputTemp, input.begin(), input.end());
     
-    // fill matrix  
+    // fill matrix, the rows are sorted as <match score, k-mer index> pairs and stored as separate arrays
+    std::pair<short,unsigned int> * row = new std::pair<short,unsigned int>[this->size];
+    this->minScore = SHRT_MAX;
+    this->maxScore = SHRT_MIN;
     for(std::vector<int>::size_type i = 0; i != permutation.size(); i++) {
         unsigned int i_index=indexer.int2index(&permutation[i][0]);
         
         for(std::vector<int>::size_type j = 0; j != permutation.size(); j++) {
             unsigned int j_index=indexer.int2index(&permutation[j][0]);
-            short score=calcScore(&permutation[i][0],&permutation[j][0],kmerSize,subMatrix);
-            scoreMatrix[i_index][j].first=score;
-            scoreMatrix[i_index][j].second=j_index;
+            short kmerScore=calcScore(&permutation[i][0],&permutation[j][0],kmerSize,subMatrix);
+            row[j].first=kmerScore;
+            row[j].second=j_index;
+        }
+        std::sort (row, row+this->size,sort_by_score());
+        for(size_t j = 0; j < this->size; j++){
+            this->score[i_index][j] = row[j].first;
+            this->index[i_index][j] = row[j].second;
+        }
+        this->maxScore = std::max(this->maxScore, row[0].first);
+        this->minScore = std::min(this->minScore, row[this->size - 1].first);
+    }
+    delete[] row;
+
+    // cutoff count table: the k-mers with a score >= cutoff against the k-mer i are score[i][0 .. count - 1]
+    const size_t range = this->maxScore - this->minScore + 1;
+    this->cutoffCount = new unsigned int[this->size * range];
+    for(size_t i = 0; i < this->size; i++){
+        unsigned int * counts = this->cutoffCount + i * range;
+        size_t count = 0;
+        for(int cutoff = this->maxScore; cutoff >= this->minScore; cutoff--){
+            while (count < this->size && this->score[i][count] >= cutoff)
+                count++;
+            counts[cutoff - this->minScore] = count;
         }
-        std::sort (scoreMatrix[i_index], scoreMatrix[i_index]+this->size,sort_by_score());
     }
-    
 }
 
 
 ExtendedSubstitutionMatrix::~ExtendedSubstitutionMatrix(){
     for(size_t i = 0; i < this->size; i++){
-        delete[]  scoreMatrix[i];
+        delete[] score[i];
+        delete[] index[i];
     }
-    delete[] scoreMatrix;
+    delete[] score;
+    delete[] index;
+    delete[] cutoffCount;
 }
 
 short ExtendedSubstitutionMatrix::calcScore(int * i_seq,int * j_seq,size_t seq_size,short **subMatrix){
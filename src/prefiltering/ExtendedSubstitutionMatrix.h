@@ -13,9 +13,28 @@ public:
     
     ~ExtendedSubstitutionMatrix();
     size_t size;
-    // <match score, k-mer index>
-    std::pair<short,unsigned int> ** scoreMatrix;
+    // the rows are padded with ROW_PADDING elements for SIMD loads beyond the end of the row
+    static const size_t ROW_PADDING = 16;
+    // match scores of the k-mer i against all k-mers, sorted by descending score
+    short ** score;
+    // k-mer indexes in the order of score[i]
+    unsigned int ** index;
+    // lowest and highest score in the matrix
+    short minScore;
+    short maxScore;
+
+    // number of k-mers with a score of at least cutoff against the k-mer i (the length of the prefix of score[i])
+    inline size_t getCutoffCount(unsigned int i, int cutoff){
+        if (cutoff <= minScore)
+            return size;
+        if (cutoff > maxScore)
+            return 0;
+        return cutoffCount[(size_t) i * (maxScore - minScore + 1) + (cutoff - minScore)];
+    }
 private: 
+    // maxScore - minScore + 1 entries for each k-mer
+    unsigned int * cutoffCount;
+
     std::vector<std::vector<int> > buildInput(size_t dimension,size_t range);
     void createCartesianProduct(
                  std::vector<std::vector<int> > & output,  // final result
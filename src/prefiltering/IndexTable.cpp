@@ -1,169 +1,507 @@
 #include "IndexTable.h"
+#include "../commons/Debug.h"
+#include "../commons/Util.h"
 
-IndexTable::IndexTable (int alphabetSize, int kmerSize, int skip)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <functional>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+static const char INDEX_FILE_MAGIC[8] = {'M','M','S','I','D','X','\0','\0'};
+
+IndexTable::IndexTable (int alphabetSize, int kmerSize, int skip, std::string spacedSeed)
 {
     this->alphabetSize = alphabetSize;
     this->kmerSize = kmerSize;
+    this->spacedSeed = spacedSeed;
     this->size = 0;
     this->skip = skip;
 
     tableSize = ipow(alphabetSize, kmerSize);
 
-    sizes = new int[tableSize];
-    memset(sizes, 0, sizeof(int) * tableSize);
+    sizes = new unsigned int[tableSize];
+    memset(sizes, 0, sizeof(unsigned int) * tableSize);
     
-    currPos = new int[tableSize];
-    memset(currPos, 0, sizeof(int) * tableSize);
+    currPos = new unsigned int[tableSize];
+    memset(currPos, 0, sizeof(unsigned int) * tableSize);
 
-    table = new int*[tableSize];
+    offsets = new size_t[tableSize];
 
-    idxer = new Indexer(alphabetSize, kmerSize);
+    idxer = new Indexer(alphabetSize, kmerSize, spacedSeed);
+    seedSpan = idxer->getSeedSpan();
+    kmerSet = new KmerSet();
 
     this->tableEntriesNum = 0;
+    this->duplicateKmers = 0;
+    this->maxKmerOcc = 0;
+    this->maskedKmersNum = 0;
+
+    this->s = NULL;
+    this->mmapData = NULL;
+    this->mmapSize = 0;
+    this->header = NULL;
+
+    this->compressedEntries = NULL;
+    this->compressedSize = 0;
+
+    this->seqOrder = NULL;
+    this->seqOrderSize = 0;
+}
+
+IndexTable::IndexTable (const char* fileName)
+{
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0){
+        Debug(Debug::ERROR) << "Could not open index table file " << fileName << "\n";
+        exit(EXIT_FAILURE);
+    }
+    struct stat sb;
+    fstat(fd, &sb);
+    this->mmapSize = sb.st_size;
+    if (mmapSize < sizeof(index_header_t)){
+        Debug(Debug::ERROR) << "Index table file " << fileName << " is truncated.\n";
+        exit(EXIT_FAILURE);
+    }
+    // MAP_SHARED: all processes on the node use the same pages
+    this->mmapData = (char*) mmap(NULL, mmapSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mmapData == MAP_FAILED){
+        Debug(Debug::ERROR) << "Could not map index table file " << fileName << " into the memory.\n";
+        exit(EXIT_FAILURE);
+    }
+
+    this->header = (index_header_t*) mmapData;
+    if (memcmp(header->magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC)) != 0 || header->version != INDEX_FILE_VERSION){
+        Debug(Debug::ERROR) << fileName << " is not an index table file of this MMseqs version. Please recreate it with mmseqs_createindex.\n";
+        exit(EXIT_FAILURE);
+    }
+
+    this->alphabetSize = header->alphabetSize;
+    this->kmerSize = header->kmerSize;
+    this->spacedSeed = std::string(header->spacedSeed);
+    this->skip = header->skip;
+    this->size = header->dbSize;
+    this->tableEntriesNum = header->tableEntriesNum;
+    this->s = NULL;
+    this->currPos = NULL;
+    this->kmerSet = NULL;
+    this->duplicateKmers = 0;
+    this->maxKmerOcc = header->maxKmerOcc;
+    this->maskedKmersNum = header->maskedKmersNum;
+
+    this->compressedSize = header->compressedSize;
+    this->seqOrderSize = header->seqOrderSize;
+
+    tableSize = ipow(alphabetSize, kmerSize);
+
+    size_t offsetsSize = sizeof(size_t) * tableSize;
+    size_t listsSize = header->compressed ? compressedSize : sizeof(unsigned int) * (size_t) tableEntriesNum;
+    if (mmapSize != sizeof(index_header_t) + offsetsSize + sizeof(unsigned int) * (tableSize + seqOrderSize) + listsSize){
+        Debug(Debug::ERROR) << "Index table file " << fileName << " is truncated.\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // the offsets follow the header directly, so they are 8 byte aligned
+    offsets = (size_t*) (mmapData + sizeof(index_header_t));
+    sizes = (unsigned int*) (mmapData + sizeof(index_header_t) + offsetsSize);
+    seqOrder = (seqOrderSize > 0) ? sizes + tableSize : NULL;
+
+    // the lists are found at their offsets in the mapped file, no table has to be built in each process
+    // and the encoded lists are only read when they are matched
+    if (header->compressed){
+        entries = NULL;
+        compressedEntries = (unsigned char*) (sizes + tableSize + seqOrderSize);
+    }
+    else {
+        compressedEntries = NULL;
+        entries = sizes + tableSize + seqOrderSize;
+    }
+
+    idxer = new Indexer(alphabetSize, kmerSize, spacedSeed);
+    seedSpan = idxer->getSeedSpan();
 }
+
 IndexTable::~IndexTable(){
-    delete[] entries;
-    delete[] table;
-    delete[] sizes;
+    if (mmapData != NULL){
+        munmap(mmapData, mmapSize);
+    }
+    else{
+        delete[] entries;
+        delete[] compressedEntries;
+        delete[] sizes;
+        delete[] seqOrder;
+        delete[] offsets;
+    }
+    delete[] currPos;
     delete idxer;
+    delete kmerSet;
 }
 
 void IndexTable::addKmerCount (Sequence* s){
+    addKmerCount(s, idxer, kmerSet);
+    this->s = s;
+}
+
+void IndexTable::addKmerCount (Sequence* s, Indexer* idxer, KmerSet* kmerSet, std::vector<unsigned int>* kmerCache){
     unsigned int kmerIdx;
+    int64_t kmerCount = 0;
+    int64_t duplicates = 0;
     s->resetCurrPos();
     idxer->reset();
+    kmerSet->clear();
+
+    size_t cacheStart = 0;
+    if (kmerCache != NULL){
+        cacheStart = kmerCache->size();
+        kmerCache->push_back(s->getId());
+        kmerCache->push_back(0);
+    }
 
-    while(s->hasNextKmer(kmerSize)){
-        kmerIdx = idxer->getNextKmerIndex(s->nextKmer(kmerSize), kmerSize);
-        sizes[kmerIdx]++;
-        tableEntriesNum++;
-        for (int i = 0; i < skip && s->hasNextKmer(kmerSize); i++){
-            idxer->getNextKmerIndex(s->nextKmer(kmerSize), kmerSize);
+    while(s->hasNextKmer(seedSpan)){
+        kmerIdx = idxer->getNextKmerIndex(s->nextKmer(seedSpan), kmerSize);
+        if (kmerSet->insert(kmerIdx)){
+            __sync_fetch_and_add(&sizes[kmerIdx], 1);
+            kmerCount++;
+            if (kmerCache != NULL)
+                kmerCache->push_back(kmerIdx);
+        }
+        else
+            duplicates++;
+        for (int i = 0; i < skip && s->hasNextKmer(seedSpan); i++){
+            idxer->getNextKmerIndex(s->nextKmer(seedSpan), kmerSize);
         }
     }
-    this->s = s;
+    __sync_fetch_and_add(&tableEntriesNum, kmerCount);
+    __sync_fetch_and_add(&duplicateKmers, duplicates);
+    if (kmerCache != NULL)
+        (*kmerCache)[cacheStart + 1] = kmerCount;
+}
+
+void IndexTable::maskFrequentKmers(unsigned int maxKmerOcc){
+    this->maxKmerOcc = maxKmerOcc;
+    if (maxKmerOcc == 0)
+        return;
+    for (size_t i = 0; i < tableSize; i++){
+        if (sizes[i] > maxKmerOcc){
+            maskedKmers.push_back(std::make_pair((unsigned int) i, sizes[i]));
+            tableEntriesNum -= sizes[i];
+            sizes[i] = 0;
+        }
+    }
+    maskedKmersNum = maskedKmers.size();
 }
 
 void IndexTable::init(){
-//    std::list<int>* sizesList = new std::list<int>();
     // allocate memory for the sequence id lists
-    entries = new int[tableEntriesNum];
-    int* it = entries;
-    // set the pointers in the index table to the start of the list for a certain k-mer
-    for (int i = 0; i < tableSize; i++){
-//        if (i < tableSize - 1)
-//            sizesList->push_back(sizes[i]);
-        if (sizes[i] > 0){
-            table[i] = it;
-            it += sizes[i];
-        }
+    entries = new unsigned int[tableEntriesNum];
+
+    // set the offsets of the lists of all k-mers in the entries array
+    // parallel prefix sum: each thread sums up the sizes of its block of k-mers,
+    // then the offsets are set within each block starting at the offset of the block
+    int threads = 1;
+#ifdef OPENMP
+    threads = omp_get_max_threads();
+#endif
+    int64_t* blockOffsets = new int64_t[threads + 1];
+    memset(blockOffsets, 0, sizeof(int64_t) * (threads + 1));
+    size_t blockSize = (tableSize + threads - 1) / threads;
+
+#pragma omp parallel for schedule(static)
+    for (int t = 0; t < threads; t++){
+        size_t blockEnd = std::min(tableSize, (t + 1) * blockSize);
+        int64_t blockSum = 0;
+        for (size_t i = t * blockSize; i < blockEnd; i++)
+            blockSum += sizes[i];
+        blockOffsets[t + 1] = blockSum;
     }
-/*    sizesList->sort();
-    std::cout << sizesList->front() << " " << sizesList->back() << "\n";
-    std::list<int>::iterator itt = sizesList->end();
-    itt--;
-    itt--;
-    int maxVal = *itt; 
-    int maxPos = maxVal / 10 + 1;
-    int* ar = new int[maxPos];
-    memset(ar, 0, sizeof(int) * (maxPos));
+    for (int t = 0; t < threads; t++)
+        blockOffsets[t + 1] += blockOffsets[t];
 
-    for (std::list<int>::iterator it = sizesList->begin(); it != sizesList->end(); it++){
-        ar[*it/10]++;
+#pragma omp parallel for schedule(static)
+    for (int t = 0; t < threads; t++){
+        size_t blockEnd = std::min(tableSize, (t + 1) * blockSize);
+        size_t offset = blockOffsets[t];
+        for (size_t i = t * blockSize; i < blockEnd; i++){
+            offsets[i] = offset;
+            offset += sizes[i];
+        }
     }
-    std::ofstream outf;
-    outf.open("/cluster/user/maria/test/kmer_cnt.out");
-    for (int i = 0; i < maxPos; i++)
-        outf << (i*10) << " " << ar[i] << "\n";
-    outf.close();
-    delete sizesList;
-    delete[] ar;*/
+    delete[] blockOffsets;
 }
 
 void IndexTable::addSequence (Sequence* s){
+    addSequence(s, idxer, kmerSet);
+    this->s = s;
+}
+
+void IndexTable::addSequence (Sequence* s, Indexer* idxer, KmerSet* kmerSet){
     // iterate over all k-mers of the sequence and add the id of s to the sequence list of the k-mer (tableDummy)
     unsigned int kmerIdx;
-    this->size++; // amount of sequences added
+    __sync_fetch_and_add(&this->size, 1); // amount of sequences added
     s->resetCurrPos();
-    this->s = s;
     idxer->reset();
+    kmerSet->clear();
 
-    while(s->hasNextKmer(kmerSize)){
-        kmerIdx = idxer->getNextKmerIndex(s->nextKmer(kmerSize), kmerSize);
-        table[kmerIdx][currPos[kmerIdx]++] = s->getId();
-        for (int i = 0; i < skip && s->hasNextKmer(kmerSize); i++){
-            idxer->getNextKmerIndex(s->nextKmer(kmerSize), kmerSize);
+    while(s->hasNextKmer(seedSpan)){
+        kmerIdx = idxer->getNextKmerIndex(s->nextKmer(seedSpan), kmerSize);
+        // reserve the next free position in the list of the k-mer
+        // the order of the ids within the list is restored by sortEntries
+        // masked k-mers have empty lists
+        if (sizes[kmerIdx] > 0 && kmerSet->insert(kmerIdx)){
+            unsigned int pos = __sync_fetch_and_add(&currPos[kmerIdx], 1);
+            entries[offsets[kmerIdx] + pos] = s->getId();
+        }
+        for (int i = 0; i < skip && s->hasNextKmer(seedSpan); i++){
+            idxer->getNextKmerIndex(s->nextKmer(seedSpan), kmerSize);
         }
     }
 }
 
-void IndexTable::removeDuplicateEntries(){
+size_t IndexTable::addSequence (const unsigned int* kmerCache){
+    unsigned int seqId = kmerCache[0];
+    unsigned int kmerCount = kmerCache[1];
+    const unsigned int* kmerIdx = kmerCache + 2;
+    __sync_fetch_and_add(&this->size, 1);
+    for (unsigned int i = 0; i < kmerCount; i++){
+        if (sizes[kmerIdx[i]] == 0)
+            continue;
+        unsigned int pos = __sync_fetch_and_add(&currPos[kmerIdx[i]], 1);
+        entries[offsets[kmerIdx[i]] + pos] = seqId;
+    }
+    return 2 + kmerCount;
+}
+
+void IndexTable::sortEntries(){
 
     delete[] currPos;
-//    std::list<int>* sizesList = new std::list<int>();
-    
-    for (int e = 0; e < tableSize; e++){
-        if (sizes[e] == 0)
-            continue;
-        int* entries = table[e];
-        int size = sizes[e];
-
-        std::sort(entries, entries+size);
-        // remove duplicates in-place
-        int boundary = 1;
-        for (int i = 1; i < size; i++){
-            if (entries[i] != entries[i-1])
-                entries[boundary++] = entries[i];
-        }
-        size = boundary;
-        sizes[e] = size;
-//        if (e < tableSize - 1)
-//            sizesList->push_back(sizes[e]);
+    currPos = NULL;
 
+    // the lists are independent of each other, dynamic scheduling because of the very different list lengths
+#pragma omp parallel for schedule(dynamic, 1024)
+    for (size_t e = 0; e < tableSize; e++){
+        unsigned int* seqList = entries + offsets[e];
+        unsigned int size = sizes[e];
+        // the lists are already sorted if the sequences were added in the order of their ids (single thread)
+        unsigned int i = 1;
+        while (i < size && seqList[i-1] < seqList[i])
+            i++;
+        if (i < size)
+            std::sort(seqList, seqList+size);
     }
-/*    sizesList->sort();
-    std::cout << sizesList->front() << " " << sizesList->back() << "\n";
-    std::list<int>::iterator itt = sizesList->end();
-    itt--;
-    itt--;
-    int maxVal = *itt;
-    int maxPos = maxVal / 10 + 1;
-    int* ar = new int[maxPos];
-    memset(ar, 0, sizeof(int) * (maxPos));
+}
+
+void IndexTable::compress(){
+    int threads = 1;
+#ifdef OPENMP
+    threads = omp_get_max_threads();
+#endif
+    unsigned int maxListSize = 0;
+    for (size_t i = 0; i < tableSize; i++)
+        maxListSize = std::max(maxListSize, sizes[i]);
+    size_t uncompressedSize = 0;
+    for (size_t i = 0; i < tableSize; i++)
+        uncompressedSize += sizeof(unsigned int) * sizes[i];
+
+    // each thread encodes a contiguous block of k-mers
+    // first pass: the encoded size of each block, second pass: encode the lists at the offset of the block
+    size_t* blockOffsets = new size_t[threads + 1];
+    memset(blockOffsets, 0, sizeof(size_t) * (threads + 1));
+    size_t blockSize = (tableSize + threads - 1) / threads;
 
-    for (std::list<int>::iterator it = sizesList->begin(); it != sizesList->end(); it++){
-        ar[*it/10]++;
+#pragma omp parallel for schedule(static)
+    for (int t = 0; t < threads; t++){
+        unsigned char* buffer = new unsigned char[SequenceListCodec::maxEncodedSize(maxListSize)];
+        size_t blockEnd = std::min(tableSize, (t + 1) * blockSize);
+        size_t blockSum = 0;
+        for (size_t i = t * blockSize; i < blockEnd; i++){
+            if (sizes[i] > 0)
+                blockSum += SequenceListCodec::encode(entries + offsets[i], sizes[i], buffer);
+        }
+        blockOffsets[t + 1] = blockSum;
+        delete[] buffer;
     }
-    std::ofstream outf;
-    outf.open("/cluster/user/maria/test/kmer_cnt_with_rm.out");
-    for (int i = 0; i < maxPos; i++)
-        outf << (i*10) << " " << ar[i] << "\n";
-    outf.close();
-    delete sizesList;
-    delete[] ar;
-*/
+    for (int t = 0; t < threads; t++)
+        blockOffsets[t + 1] += blockOffsets[t];
+
+    compressedSize = blockOffsets[threads];
+    compressedEntries = new unsigned char[compressedSize];
 
+#pragma omp parallel for schedule(static)
+    for (int t = 0; t < threads; t++){
+        size_t blockEnd = std::min(tableSize, (t + 1) * blockSize);
+        size_t offset = blockOffsets[t];
+        for (size_t i = t * blockSize; i < blockEnd; i++){
+            // offsets[i] is replaced by the byte offset of the encoded list after reading the uncompressed list
+            unsigned int* seqList = entries + offsets[i];
+            offsets[i] = offset;
+            if (sizes[i] > 0)
+                offset += SequenceListCodec::encode(seqList, sizes[i], compressedEntries + offset);
+        }
+    }
+    delete[] blockOffsets;
+
+    delete[] entries;
+    entries = NULL;
+
+    Debug(Debug::INFO) << "Index table compressed from " << uncompressedSize / 1024 / 1024 << " MB to " << compressedSize / 1024 / 1024 << " MB.\n";
 }
 
 void IndexTable::print(){
-    for (int i = 0; i < tableSize; i++){
+    for (size_t i = 0; i < tableSize; i++){
         if (sizes[i] > 0){
             idxer->printKmer(i, kmerSize, s->int2aa);
             std::cout << "\n";
-            for (int j = 0; j < sizes[i]; j++){
-                std::cout << "\t" << table[i][j] << "\n";
+            if (isCompressed()){
+                SequenceListCodec decoder;
+                unsigned int* buffer = (unsigned int*) Util::mem_align(16, sizeof(unsigned int) * SequenceListCodec::BLOCK_SIZE);
+                decoder.initDecoding(compressedEntries + offsets[i], sizes[i]);
+                int n;
+                while ((n = decoder.decodeNextBlock(buffer)) > 0){
+                    for (int j = 0; j < n; j++)
+                        std::cout << "\t" << buffer[j] << "\n";
+                }
+                free(buffer);
+            }
+            else {
+                for (unsigned int j = 0; j < sizes[i]; j++){
+                    std::cout << "\t" << entries[offsets[i] + j] << "\n";
+                }
             }
         }
     }
 }
 
-int* IndexTable::getDBSeqList (int kmer, int* matchedListSize){
+void IndexTable::printKmerStatistics(char* int2aa, int topN){
+    // number of k-mers and entries in the list length bins [1], [2,3], [4,7], ...
+    const int bins = 33;
+    size_t binKmers[bins];
+    size_t binEntries[bins];
+    memset(binKmers, 0, sizeof(size_t) * bins);
+    memset(binEntries, 0, sizeof(size_t) * bins);
+    size_t usedKmers = 0;
+    unsigned int maxListSize = 0;
+    // min-heap of the topN longest lists (list length, k-mer index)
+    std::vector<std::pair<unsigned int, unsigned int> > top;
+    std::greater<std::pair<unsigned int, unsigned int> > cmp;
+    for (size_t i = 0; i < tableSize + maskedKmers.size(); i++){
+        std::pair<unsigned int, unsigned int> kmer;
+        if (i < tableSize)
+            kmer = std::make_pair(sizes[i], (unsigned int) i);
+        else
+            kmer = std::make_pair(maskedKmers[i - tableSize].second, maskedKmers[i - tableSize].first);
+        if (kmer.first == 0)
+            continue;
+        int bin = 0;
+        while ((kmer.first >> (bin + 1)) != 0)
+            bin++;
+        binKmers[bin]++;
+        binEntries[bin] += kmer.first;
+        if (i < tableSize){
+            usedKmers++;
+            maxListSize = std::max(maxListSize, kmer.first);
+        }
+        if ((int) top.size() < topN){
+            top.push_back(kmer);
+            std::push_heap(top.begin(), top.end(), cmp);
+        }
+        else if (topN > 0 && kmer > top.front()){
+            std::pop_heap(top.begin(), top.end(), cmp);
+            top.back() = kmer;
+            std::push_heap(top.begin(), top.end(), cmp);
+        }
+    }
+
+    Debug(Debug::INFO) << "Index table k-mer statistics:\n";
+    Debug(Debug::INFO) << "k-mers with sequences: " << usedKmers << " of " << tableSize << ", entries: " << tableEntriesNum
+        << ", mean list length: " << (usedKmers > 0 ? (double) tableEntriesNum / usedKmers : 0.0) << ", max. list length: " << maxListSize << "\n";
+    if (maxKmerOcc > 0)
+        Debug(Debug::INFO) << "k-mers occurring in more than " << maxKmerOcc << " sequences (masked): " << maskedKmersNum << "\n";
+    Debug(Debug::INFO) << "list length\tk-mers\tentries\n";
+    for (int b = 0; b < bins; b++){
+        if (binKmers[b] == 0)
+            continue;
+        Debug(Debug::INFO) << (1ULL << b) << "-" << ((1ULL << (b + 1)) - 1) << "\t" << binKmers[b] << "\t" << binEntries[b] << "\n";
+    }
+
+    std::sort_heap(top.begin(), top.end(), cmp);
+    Debug(Debug::INFO) << "Most frequent k-mers:\n";
+    int* kmer = new int[kmerSize];
+    for (size_t i = 0; i < top.size(); i++){
+        idxer->index2int(kmer, top[i].second, kmerSize);
+        std::string kmerStr;
+        for (int j = 0; j < kmerSize; j++)
+            kmerStr.push_back(int2aa[kmer[j]]);
+        Debug(Debug::INFO) << kmerStr << "\t" << top[i].first << (sizes[top[i].second] == 0 ? "\t(masked)" : "") << "\n";
+    }
+    delete[] kmer;
+    Debug(Debug::INFO) << "\n";
+}
+
+void IndexTable::setSeqOrder(const std::vector<size_t>& order){
+    delete[] seqOrder;
+    seqOrderSize = order.size();
+    seqOrder = new unsigned int[seqOrderSize];
+    for (size_t i = 0; i < seqOrderSize; i++)
+        seqOrder[i] = order[i];
+}
+
+void IndexTable::writeToFile(const char* fileName, unsigned int matrixHash, unsigned int dbHash, size_t dbSize){
+    index_header_t h;
+    memset(&h, 0, sizeof(index_header_t));
+    memcpy(h.magic, INDEX_FILE_MAGIC, sizeof(INDEX_FILE_MAGIC));
+    h.version = INDEX_FILE_VERSION;
+    h.alphabetSize = alphabetSize;
+    h.kmerSize = kmerSize;
+    strncpy(h.spacedSeed, spacedSeed.c_str(), sizeof(h.spacedSeed) - 1);
+    h.skip = skip;
+    h.matrixHash = matrixHash;
+    h.dbHash = dbHash;
+    h.dbSize = dbSize;
+    h.tableEntriesNum = tableEntriesNum;
+    h.compressed = isCompressed();
+    h.compressedSize = compressedSize;
+    h.maxKmerOcc = maxKmerOcc;
+    h.maskedKmersNum = maskedKmersNum;
+    h.seqOrderSize = seqOrderSize;
+
+    FILE* outFile = fopen(fileName, "wb");
+    if (outFile == NULL){
+        Debug(Debug::ERROR) << "Could not open " << fileName << " for writing.\n";
+        exit(EXIT_FAILURE);
+    }
+    bool ok = (fwrite(&h, sizeof(index_header_t), 1, outFile) == 1);
+    ok = ok && (fwrite(offsets, sizeof(size_t), tableSize, outFile) == tableSize);
+    ok = ok && (fwrite(sizes, sizeof(unsigned int), tableSize, outFile) == tableSize);
+    if (seqOrderSize > 0)
+        ok = ok && (fwrite(seqOrder, sizeof(unsigned int), seqOrderSize, outFile) == seqOrderSize);
+    // the lists are stored without gaps
+    if (isCompressed())
+        ok = ok && (fwrite(compressedEntries, 1, compressedSize, outFile) == compressedSize);
+    else
+        ok = ok && (fwrite(entries, sizeof(unsigned int), tableEntriesNum, outFile) == (size_t) tableEntriesNum);
+    if (fclose(outFile) != 0 || !ok){
+        Debug(Debug::ERROR) << "Error while writing the index table file " << fileName << "\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+unsigned int* IndexTable::getDBSeqList (unsigned int kmer, size_t* matchedListSize){
+    *matchedListSize = sizes[kmer];
+    return entries + offsets[kmer];
+}
+
+unsigned char* IndexTable::getCompressedDBSeqList (unsigned int kmer, size_t* matchedListSize){
     *matchedListSize = sizes[kmer];
-    return table[kmer];
+    return compressedEntries + offsets[kmer];
 }
 
-int IndexTable::ipow (int base, int exponent){
-    int res = 1;
+size_t IndexTable::ipow (int base, int exponent){
+    size_t res = 1;
     for (int i = 0; i < exponent; i++)
         res = res*base;
     return res;
@@ -10,57 +10,174 @@
 #include <fstream>
 #include <algorithm>
 #include <list>
+#include <vector>
+#include <utility>
 
 #include "../commons/Sequence.h"
 #include "Indexer.h"
+#include "KmerSet.h"
+#include "SequenceListCodec.h"
+
+// header of the index table file written by mmseqs_createindex
+// the list offsets (tableSize size_ts, byte offsets for compressed index tables), the sizes array (tableSize unsigned ints),
+// the sequence order (seqOrderSize unsigned ints) and the compacted sequence lists (tableEntriesNum unsigned ints) follow directly,
+// for compressed index tables the encoded sequence lists (compressedSize bytes)
+typedef struct {
+    char magic[8];
+    int version;
+    int alphabetSize;
+    int kmerSize;
+    int skip;
+    // fingerprint of the substitution matrix (alphabet reduction changes the k-mer indices)
+    unsigned int matrixHash;
+    // fingerprint of the sequence lengths of the target DB in the local (sorted) id order
+    unsigned int dbHash;
+    // number of sequences in the target DB
+    size_t dbSize;
+    int64_t tableEntriesNum;
+    int compressed;
+    int64_t compressedSize;
+    // spaced seed pattern, empty for contiguous k-mers
+    char spacedSeed[32];
+    // k-mers occurring in more than maxKmerOcc sequences have empty lists, 0: no limit
+    unsigned int maxKmerOcc;
+    int64_t maskedKmersNum;
+    // dbSize if the sequences were renumbered for the index table (see Prefiltering::getCacheLocalOrder), otherwise 0
+    int64_t seqOrderSize;
+} index_header_t;
 
 class IndexTable {
 
     public:
 
-        IndexTable (int alphabetSize, int kmerSize, int skip);
+        // spacedSeed: pattern of the k-mer positions in the sequence window, e.g. "1101011" (see Indexer)
+        IndexTable (int alphabetSize, int kmerSize, int skip, std::string spacedSeed = "");
+
+        // maps a precomputed index table file read-only into the memory
+        // several processes using the same file share one copy of the index in the page cache
+        IndexTable (const char* fileName);
 
         ~IndexTable();
 
         // count k-mers in the sequence, so enough memory for the sequence lists can be allocated in the end
+        // k-mers occurring several times in the sequence are counted once
         void addKmerCount (Sequence* s);
 
-        // add k-mers of the sequence to the index table
+        // add k-mers of the sequence to the index table, each k-mer only once
         void addSequence (Sequence* s);
 
-        void removeDuplicateEntries();
+        // thread-safe versions of addKmerCount and addSequence for the parallel index table construction
+        // each thread has to provide its own Indexer and KmerSet
+        // if kmerCache is given, the sequence id, the number of distinct k-mers and the k-mer indices are appended to it,
+        // so the sequence can be added later with addSequence(kmerCache) without mapping it again
+        void addKmerCount (Sequence* s, Indexer* idxer, KmerSet* kmerSet, std::vector<unsigned int>* kmerCache = NULL);
+
+        void addSequence (Sequence* s, Indexer* idxer, KmerSet* kmerSet);
+
+        // add a sequence from a k-mer cache filled by addKmerCount, returns the number of cache elements used
+        size_t addSequence (const unsigned int* kmerCache);
+
+        // sorts the sequence lists, the k-mers are processed in parallel
+        // the lists contain no duplicates, they are removed already in addKmerCount and addSequence
+        void sortEntries();
+
+        int64_t getTableEntriesNum() { return tableEntriesNum; }
+
+        // number of k-mer occurrences that were not added because the k-mer occurred in the same sequence before
+        int64_t getDuplicateKmerCount() { return duplicateKmers; }
+
+        // removes the k-mers occurring in more than maxKmerOcc sequences (poly-Q, poly-A, frequent motifs) from the index table
+        // their lists would be walked for every query containing them and dominate the matching time
+        // has to be called after the k-mer counting and before init, the masked k-mers get empty lists
+        void maskFrequentKmers(unsigned int maxKmerOcc);
+
+        unsigned int getMaxKmerOcc() { return maxKmerOcc; }
+
+        int64_t getMaskedKmerCount() { return maskedKmersNum; }
 
         // init the arrays for the sequence lists 
         void init();
 
+        // replaces the sequence lists by delta encoded, bit-packed lists (see SequenceListCodec)
+        // has to be called after sortEntries
+        void compress();
+
+        bool isCompressed() { return compressedEntries != NULL; }
+
+        // number of DB sequences containing this k-mer
+        size_t getListSize (unsigned int kmer) { return sizes[kmer]; }
+
         // get list of DB sequences containing this k-mer
-        int* getDBSeqList (int kmer, int* matchedListSize);
+        unsigned int* getDBSeqList (unsigned int kmer, size_t* matchedListSize);
+
+        // get the encoded list of DB sequences containing this k-mer, only for compressed index tables
+        unsigned char* getCompressedDBSeqList (unsigned int kmer, size_t* matchedListSize);
 
         void print();
 
+        // prints the distribution of the sequence list lengths and the topN most frequent k-mers (including the masked ones)
+        void printKmerStatistics(char* int2aa, int topN = 10);
+
+        // write the index table into a file that can be mapped by IndexTable(fileName)
+        void writeToFile(const char* fileName, unsigned int matrixHash, unsigned int dbHash, size_t dbSize);
+
+        // only set for index tables read from a file
+        index_header_t* getHeader() { return header; }
+
+        std::string getSpacedSeed() { return spacedSeed; }
+
+        // store the order of the target sequences the sequence ids refer to in the index table file
+        // order[i] is the local id in the length sorted target DB of the sequence with the id i
+        void setSeqOrder(const std::vector<size_t>& order);
+
+        // NULL if the sequence ids refer to the length sorted target DB
+        const unsigned int* getSeqOrder() { return seqOrder; }
+
+        size_t getSeqOrderSize() { return seqOrderSize; }
+
+        // the longest spaced seed pattern that can be stored in the index table file
+        static const size_t MAX_SPACED_SEED_LEN = 31;
+
         // alphabetSize**kmerSize
-        int tableSize;
+        size_t tableSize;
+
+        static const int INDEX_FILE_VERSION = 7;
 
     private:
-        int ipow (int base, int exponent);
+        size_t ipow (int base, int exponent);
 
-        // Index table: contains pointers to the point in the entries array where starts the list of sequence ids for a certain k-mer
-        int** table;
+        // Index table: position in the entries array where the list of sequence ids for a certain k-mer starts,
+        // for compressed index tables the byte position of the encoded list in compressedEntries
+        // stored in the index table file, a mapped index table uses the offsets of the file directly
+        size_t* offsets;
 
         // Index table entries: ids of sequences containing a certain k-mer, stored sequentially in the memory
-        int* entries;
+        unsigned int* entries;
 
-        int* sizes;
+        // sequence list lengths, the sequence ids are unsigned ints, so up to 2^32 - 1 sequences can be indexed
+        unsigned int* sizes;
+
+        // encoded sequence lists, stored sequentially in the memory
+        unsigned char* compressedEntries;
+
+        size_t compressedSize;
 
         // only for init: current position in the DB id array of the index table where the next sequence id can be written
-        int* currPos;
+        unsigned int* currPos;
 
         Indexer* idxer;
+
+        KmerSet* kmerSet;
     
         int alphabetSize;
 
         int kmerSize;
 
+        std::string spacedSeed;
+
+        // length of the sequence window of one k-mer
+        int seedSpan;
+
         Sequence* s;
 
         // number of skipped k-mers
@@ -72,6 +189,25 @@ class IndexTable {
 
         // number of entries in all sequence lists
         int64_t tableEntriesNum;
+
+        int64_t duplicateKmers;
+
+        // max. sequence list length, 0: no limit
+        unsigned int maxKmerOcc;
+
+        int64_t maskedKmersNum;
+
+        // masked k-mers and their number of occurrences, only for index tables built in memory
+        std::vector<std::pair<unsigned int, unsigned int> > maskedKmers;
+
+        unsigned int* seqOrder;
+
+        size_t seqOrderSize;
+
+        // memory mapped index table file
+        char* mmapData;
+        size_t mmapSize;
+        index_header_t* header;
 };
 
 #endif
@@ -1,5 +1,6 @@
 #include "Indexer.h"
-Indexer::Indexer(const int alphabetSize, const int maxKmerSize){
+#include <cstdlib>
+Indexer::Indexer(const int alphabetSize, const int maxKmerSize, std::string spacedSeed){
     this->maxKmerSize = maxKmerSize;
     this->powers = new int[maxKmerSize];
     this->alphabetSize = alphabetSize;
@@ -16,11 +17,51 @@ Indexer::Indexer(const int alphabetSize, const int maxKmerSize){
     this->lastKmerIndex = this->maxKmerIndex;
 
     workspace = new int[100];
+
+    this->seedPositions = new int[maxKmerSize];
+    this->spaced = (spacedSeed.length() > 0);
+    if (spaced){
+        if (getSpacedSeedWeight(spacedSeed) != maxKmerSize){
+            std::cerr << "ERROR: The spaced seed " << spacedSeed << " does not have " << maxKmerSize << " k-mer positions.\n";
+            exit(EXIT_FAILURE);
+        }
+        this->seedSpan = spacedSeed.length();
+        int k = 0;
+        for (int i = 0; i < seedSpan; i++){
+            if (spacedSeed[i] == '1')
+                seedPositions[k++] = i;
+        }
+    }
+    else {
+        this->seedSpan = maxKmerSize;
+        for (int i = 0; i < maxKmerSize; i++)
+            seedPositions[i] = i;
+    }
 }
 
 Indexer::~Indexer(){
     delete[] this->powers;
     delete[] workspace;
+    delete[] seedPositions;
+}
+
+int Indexer::getSpacedSeedWeight(std::string spacedSeed){
+    int weight = 0;
+    for (size_t i = 0; i < spacedSeed.length(); i++){
+        if (spacedSeed[i] == '1')
+            weight++;
+        else if (spacedSeed[i] != '0')
+            return 0;
+    }
+    // the window has to start and end with a k-mer position
+    if (spacedSeed.length() == 0 || spacedSeed[0] != '1' || spacedSeed[spacedSeed.length() - 1] != '1')
+        return 0;
+    return weight;
+}
+
+void Indexer::getSpacedKmer(const int* window, int* kmer){
+    for (int i = 0; i < maxKmerSize; i++)
+        kmer[i] = window[seedPositions[i]];
 }
 
 unsigned int Indexer::int2index( const int *int_seq,const int begin,const int end){
@@ -44,6 +85,13 @@ void Indexer::index2int(int* int_seq, unsigned int idx, int kmerSize){
 }
 
 unsigned int Indexer::getNextKmerIndex (const int* kmer, int kmerSize){
+    if (spaced){
+        // the windows of neighbouring spaced k-mers do not share a contiguous part, no rolling update
+        this->lastKmerIndex = 0;
+        for (int i = 0; i < kmerSize; i++)
+            this->lastKmerIndex += kmer[seedPositions[i]] * this->powers[i];
+        return this->lastKmerIndex;
+    }
     if (this->lastKmerIndex == this->maxKmerIndex)
         return int2index(kmer, 0, kmerSize);
     else{
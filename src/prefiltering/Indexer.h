@@ -4,6 +4,8 @@
 // Written by Maria Hauser mhauser@genzentrum.lmu.de, Martin Steinegger Martin.Steinegger@campus.lmu.de
 // 
 // Manages the conversion of the int coded k-mer into a int index and vice versa.
+// Supports spaced seeds: a pattern like "1101011" selects the k-mer residues ('1') within a window of the sequence,
+// the number of '1' positions is the k-mer size.
 //
 
 
@@ -13,7 +15,7 @@
 class Indexer{
 	
 	public:
-        Indexer(const int alphabetSize, const int maxKmerSize);
+        Indexer(const int alphabetSize, const int maxKmerSize, std::string spacedSeed = "");
         ~Indexer();
 
         // get the index of the k-mer, beginning at "begin" in the int_seq and ending at "end"
@@ -25,8 +27,23 @@ class Indexer{
         void index2int(int* int_seq, unsigned int idx, int kmerSize);
        
         // k-mer iterator, remembers the last k-mer
+        // for spaced seeds, kmer points to the start of the window and the index is computed from the seed positions
         unsigned int getNextKmerIndex(const int* kmer, int kmerSize);
 
+        // copy the k-mer residues of the window into kmer
+        void getSpacedKmer(const int* window, int* kmer);
+
+        bool isSpaced() { return spaced; }
+
+        // length of the window covered by one k-mer (k for contiguous k-mers)
+        int getSeedSpan() { return seedSpan; }
+
+        // positions of the k-mer residues within the window
+        const int* getSeedPositions() { return seedPositions; }
+
+        // checks the pattern and returns the number of k-mer positions, 0 for an invalid pattern
+        static int getSpacedSeedWeight(std::string spacedSeed);
+
         // reset the last k-mer
         void reset();
 
@@ -50,5 +67,11 @@ class Indexer{
         unsigned int maxKmerIndex;
 
         int* workspace;
+
+        bool spaced;
+
+        int seedSpan;
+
+        int* seedPositions;
 };
 #endif
@@ -1,5 +1,8 @@
 #include "KmerGenerator.h"
 
+#include <emmintrin.h>
+#include <immintrin.h>
+
 KmerGenerator::KmerGenerator(size_t kmerSize,size_t alphabetSize, short threshold,
                              ExtendedSubstitutionMatrix * three,ExtendedSubstitutionMatrix * two ){
     this->threshold = threshold;
@@ -7,6 +10,8 @@ KmerGenerator::KmerGenerator(size_t kmerSize,size_t alphabetSize, short threshol
     this->three = three;
     this->two = two;
     this->indexer = new Indexer((int) alphabetSize, (int)kmerSize);
+    __builtin_cpu_init();
+    this->useAVX2 = __builtin_cpu_supports("avx2");
     calcDivideStrategy();
 }
 
@@ -18,9 +23,11 @@ KmerGenerator::~KmerGenerator(){
     delete [] this->divideStep;
     delete [] this->matrixLookup;
     for(size_t i = 0 ; i < this->divideStepCount - 1; i++){
-        delete[] outputArray[i];
+        delete[] outputScore[i];
+        delete[] outputIndex[i];
     }
-    delete [] outputArray;
+    delete [] outputScore;
+    delete [] outputIndex;
     delete indexer;
 }
 
@@ -78,9 +85,12 @@ void KmerGenerator::calcDivideStrategy(){
 
 
 void KmerGenerator::initResultList(size_t divide_steps){
-    outputArray = new std::pair<short, unsigned int> *[divide_steps];
+    outputScore = new short *[divide_steps];
+    outputIndex = new unsigned int *[divide_steps];
     for(size_t i = 0 ; i < divide_steps - 1; i++){
-        outputArray[i] = new std::pair<short, unsigned int> [VEC_LIMIT];
+        // padding for the SIMD blocks of calculateArrayProduct
+        outputScore[i] = new short[VEC_LIMIT + ExtendedSubstitutionMatrix::ROW_PADDING];
+        outputIndex[i] = new unsigned int[VEC_LIMIT + ExtendedSubstitutionMatrix::ROW_PADDING];
     }
 }
 
@@ -100,8 +110,7 @@ KmerGeneratorResult KmerGenerator::generateKmerList(const int * int_seq){
 
         ExtendedSubstitutionMatrix * extMatrix= this->matrixLookup[i];
         // get highest element in array for index
-        const std::pair<short,unsigned int>  score=(const std::pair<short,unsigned int> ) extMatrix->scoreMatrix[index][0];
-        this->highestScorePerArray[i]=score.first; //highest score
+        this->highestScorePerArray[i]=extMatrix->score[index][0]; //highest score
         dividerBefore+=divider;
         
     }
@@ -114,72 +123,130 @@ KmerGeneratorResult KmerGenerator::generateKmerList(const int * int_seq){
     size_t index=this->kmerIndex[0];
     ExtendedSubstitutionMatrix * extMatrix= this->matrixLookup[0];
     size_t sizeInputMatrix= extMatrix->size;
-    const std::pair<short,unsigned int> * inputArray=extMatrix->scoreMatrix[index];
+    const short * inputScore=extMatrix->score[index];
+    const unsigned int * inputIndex=extMatrix->index[index];
     
     size_t i;
     for(i = 0; i < this->divideStepCount-1; i++){
         const size_t index=this->kmerIndex[i+1];
         extMatrix= this->matrixLookup[i+1];
-        const std::pair<short, unsigned int >  * nextIndexScoreArray=extMatrix->scoreMatrix[index];
         
-        int lastElm=calculateArrayProduct(inputArray,
+        int lastElm=calculateArrayProduct(inputScore,
+                                   inputIndex,
                                    sizeInputMatrix,
-                                   nextIndexScoreArray,
-                                   extMatrix->size,
-                                   outputArray[i],
+                                   extMatrix,
+                                   index,
+                                   outputScore[i],
+                                   outputIndex[i],
                                    cutoff1,
                                    possibleRest[i+1],
                                    this->stepMultiplicator[i+1]);
         if(lastElm==-1){
             retList.count=0;
-            retList.scoreKmerList=NULL;
+            retList.score=NULL;
+            retList.index=NULL;
             return retList;
         }
             
-        inputArray=(const std::pair<short,unsigned int> *) this->outputArray[i];
+        inputScore=this->outputScore[i];
+        inputIndex=this->outputIndex[i];
         cutoff1 = -1000; // we need all that came through 
         retList.count = lastElm + 1;
         sizeInputMatrix = retList.count; // because old data can be under it
     }
-    retList.scoreKmerList=outputArray[i-1];
+    retList.score=outputScore[i-1];
+    retList.index=outputIndex[i-1];
     return retList;
 }
 
 
 
 
-int KmerGenerator::calculateArrayProduct( const std::pair<short,unsigned int> * array1,
+int KmerGenerator::calculateArrayProduct( const short * array1Score,
+                                          const unsigned int * array1Index,
                                           const size_t array1Size,
-                                          const std::pair<short,unsigned int> * array2,
-                                          const size_t array2Size,
-                                          std::pair<short,unsigned int> * outputvec,
+                                          ExtendedSubstitutionMatrix * extMatrix2,
+                                          const unsigned int row2,
+                                          short * outputScore,
+                                          unsigned int * outputIndex,
                                           const short cutoff1,const short possibleRest,
                                           const unsigned int pow){
-    int counter=-1;
+    if (useAVX2)
+        return calculateArrayProductAVX2(array1Score, array1Index, array1Size, extMatrix2, row2,
+                                         outputScore, outputIndex, cutoff1, possibleRest, pow);
+    const short * array2Score = extMatrix2->score[row2];
+    const unsigned int * array2Index = extMatrix2->index[row2];
+    const __m128i pow_128 = _mm_set1_epi32(pow);
+    size_t counter=0;
     for(size_t i = 0 ; i< array1Size;i++){
-        const std::pair<short, unsigned int> array1Pair=array1[i];
-        const short score_i = array1Pair.first;
-        const unsigned int kmer_i = array1Pair.second;
+        const short score_i = array1Score[i];
+        const unsigned int kmer_i = array1Index[i];
         if(score_i < cutoff1 )
             break;
-        const short cutoff2=this->threshold-score_i-possibleRest;
-        for(size_t j = 0; j < array2Size;j++){
-            if(counter+1 >= (int) VEC_LIMIT)
-                return counter;
-            
-            const std::pair<short, unsigned int> array2Pair=array2[j];
-            const short score_j = array2Pair.first;
-            const unsigned int kmer_j = array2Pair.second;
-
-            if(score_j < cutoff2)
-                break;
-            counter++;
-            std::pair<short, unsigned int> * result=&outputvec[counter];
-            result->first=score_i+score_j;
-            result->second=kmer_i+(kmer_j*pow);
-
+        // the rows of the extended matrix are sorted, the cutoff table gives the number of elements above cutoff2
+        const int cutoff2=this->threshold-score_i-possibleRest;
+        const size_t count = std::min(extMatrix2->getCutoffCount(row2, cutoff2), VEC_LIMIT - counter);
+        const __m128i score_i_128 = _mm_set1_epi16(score_i);
+        const __m128i kmer_i_128 = _mm_set1_epi32(kmer_i);
+        short * outScore = outputScore + counter;
+        unsigned int * outIndex = outputIndex + counter;
+        // whole blocks of 8 elements, the rows and the output arrays are padded
+        // and the elements beyond count are overwritten by the next row
+        for(size_t j = 0; j < count; j += 8){
+            _mm_storeu_si128((__m128i *) (outScore + j), _mm_add_epi16(score_i_128, _mm_loadu_si128((__m128i *) (array2Score + j))));
+            // SSE2 has no 32 bit multiplication, the even and odd elements are multiplied separately
+            for(size_t k = j; k < j + 8; k += 4){
+                const __m128i index = _mm_loadu_si128((__m128i *) (array2Index + k));
+                const __m128i even = _mm_mul_epu32(index, pow_128);
+                const __m128i odd = _mm_mul_epu32(_mm_srli_epi64(index, 32), pow_128);
+                const __m128i product = _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                                                           _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+                _mm_storeu_si128((__m128i *) (outIndex + k), _mm_add_epi32(kmer_i_128, product));
+            }
         }
+        counter += count;
+        if(counter >= VEC_LIMIT)
+            break;
     }
-    return counter;
+    return (int) counter - 1;
 }
 
+__attribute__((target("avx2")))
+int KmerGenerator::calculateArrayProductAVX2( const short * array1Score,
+                                              const unsigned int * array1Index,
+                                              const size_t array1Size,
+                                              ExtendedSubstitutionMatrix * extMatrix2,
+                                              const unsigned int row2,
+                                              short * outputScore,
+                                              unsigned int * outputIndex,
+                                              const short cutoff1,const short possibleRest,
+                                              const unsigned int pow){
+    const short * array2Score = extMatrix2->score[row2];
+    const unsigned int * array2Index = extMatrix2->index[row2];
+    const __m256i pow_256 = _mm256_set1_epi32(pow);
+    size_t counter=0;
+    for(size_t i = 0 ; i< array1Size;i++){
+        const short score_i = array1Score[i];
+        const unsigned int kmer_i = array1Index[i];
+        if(score_i < cutoff1 )
+            break;
+        const int cutoff2=this->threshold-score_i-possibleRest;
+        const size_t count = std::min(extMatrix2->getCutoffCount(row2, cutoff2), VEC_LIMIT - counter);
+        const __m256i score_i_256 = _mm256_set1_epi16(score_i);
+        const __m256i kmer_i_256 = _mm256_set1_epi32(kmer_i);
+        short * outScore = outputScore + counter;
+        unsigned int * outIndex = outputIndex + counter;
+        // whole blocks of 16 elements
+        for(size_t j = 0; j < count; j += 16){
+            _mm256_storeu_si256((__m256i *) (outScore + j), _mm256_add_epi16(score_i_256, _mm256_loadu_si256((__m256i *) (array2Score + j))));
+            const __m256i index1 = _mm256_loadu_si256((__m256i *) (array2Index + j));
+            const __m256i index2 = _mm256_loadu_si256((__m256i *) (array2Index + j + 8));
+            _mm256_storeu_si256((__m256i *) (outIndex + j), _mm256_add_epi32(kmer_i_256, _mm256_mullo_epi32(index1, pow_256)));
+            _mm256_storeu_si256((__m256i *) (outIndex + j + 8), _mm256_add_epi32(kmer_i_256, _mm256_mullo_epi32(index2, pow_256)));
+        }
+        counter += count;
+        if(counter >= VEC_LIMIT)
+            break;
+    }
+    return (int) counter - 1;
+}
@@ -8,8 +8,9 @@
 
 typedef struct {
     size_t count;
-    // score, k-mer index
-    std::pair<short, unsigned int> * scoreKmerList;
+    // scores and k-mer indexes of the similar k-mers
+    short * score;
+    unsigned int * index;
 } KmerGeneratorResult;
 
 
@@ -23,15 +24,32 @@ class KmerGenerator
         /*calculates the kmer list */
         KmerGeneratorResult generateKmerList(const int * intSeq);
 
+        /* use the AVX2 kernel if the CPU supports it (default), otherwise SSE2 */
+        void setAVX2(bool useAVX2) { this->useAVX2 = useAVX2 && __builtin_cpu_supports("avx2"); }
+
 
     private:
     
         /*creates the product between two arrays and write it to the output array */
-        int calculateArrayProduct( const std::pair<short,unsigned int> * array1,
+        /* the second array is the row row2 of extMatrix2, the elements above the cutoff are a prefix of the row */
+        int calculateArrayProduct( const short * array1Score,
+                              const unsigned int * array1Index,
+                              const size_t array1Size,
+                              ExtendedSubstitutionMatrix * extMatrix2,
+                              const unsigned int row2,
+                              short * outputScore,
+                              unsigned int * outputIndex,
+                              const short cutoff1,const short possibleRest,
+                              const unsigned int pow);
+
+        /* AVX2 version of calculateArrayProduct */
+        int calculateArrayProductAVX2( const short * array1Score,
+                              const unsigned int * array1Index,
                               const size_t array1Size,
-                              const std::pair<short,unsigned int> * array2,
-                              const size_t array2Size,
-                              std::pair<short,unsigned int> * outputvec,
+                              ExtendedSubstitutionMatrix * extMatrix2,
+                              const unsigned int row2,
+                              short * outputScore,
+                              unsigned int * outputIndex,
                               const short cutoff1,const short possibleRest,
                               const unsigned int pow);
     
@@ -54,7 +72,10 @@ class KmerGenerator
         ExtendedSubstitutionMatrix ** matrixLookup; 
         ExtendedSubstitutionMatrix * three; 
         ExtendedSubstitutionMatrix * two; 
-        std::pair<short, unsigned int>  ** outputArray;
+        short ** outputScore;
+        unsigned int ** outputIndex;
+        /* AVX2 kernel for the array product */
+        bool useAVX2;
     
         /* kmer splitting stragety (3,2)
            fill up the divide step and calls init_result_list */
@@ -0,0 +1,90 @@
+#include "KmerListCache.h"
+
+#include <cstdlib>
+#include <cstring>
+
+KmerListCache::KmerListCache(size_t maxMemory){
+    this->maxMemory = maxMemory;
+    this->memory = 0;
+    this->listsNum = 0;
+    this->full = false;
+    this->hits = 0;
+    this->misses = 0;
+
+    // power of two number of slots
+    slotBits = 10;
+    while (((size_t) 1 << slotBits) < maxMemory / AVG_LIST_MEMORY)
+        slotBits++;
+    slotsNum = (size_t) 1 << slotBits;
+    slots = new CachedList* volatile [slotsNum];
+    for (size_t i = 0; i < slotsNum; i++)
+        slots[i] = NULL;
+}
+
+KmerListCache::~KmerListCache(){
+    for (size_t i = 0; i < slotsNum; i++)
+        free(slots[i]);
+    delete[] slots;
+}
+
+size_t KmerListCache::getSlot(unsigned int kmerIdx){
+    // multiplicative hashing, the k-mer indexes of similar k-mers differ in few digits
+    return (size_t) (((unsigned long long) kmerIdx * 0x9E3779B97F4A7C15ULL) >> (64 - slotBits));
+}
+
+bool KmerListCache::get(unsigned int kmerIdx, KmerGeneratorResult* list){
+    size_t slot = getSlot(kmerIdx);
+    for (int i = 0; i < MAX_PROBES; i++){
+        CachedList* cached = slots[slot];
+        // the lists are never removed, the k-mer can not be in a later slot
+        if (cached == NULL)
+            return false;
+        if (cached->kmerIdx == kmerIdx){
+            list->count = cached->count;
+            list->index = (unsigned int*) (cached + 1);
+            list->score = (short*) (list->index + cached->count);
+            return true;
+        }
+        slot = (slot + 1) & (slotsNum - 1);
+    }
+    return false;
+}
+
+void KmerListCache::add(unsigned int kmerIdx, KmerGeneratorResult list){
+    if (full)
+        return;
+    const size_t size = sizeof(CachedList) + list.count * (sizeof(unsigned int) + sizeof(short));
+    if (__sync_add_and_fetch(&memory, size) > maxMemory){
+        // only this list is skipped, shorter lists may still fit into the remaining memory
+        const size_t used = __sync_sub_and_fetch(&memory, size);
+        if (used + MIN_FREE_MEMORY > maxMemory)
+            full = true;
+        return;
+    }
+    CachedList* cached = (CachedList*) malloc(size);
+    cached->kmerIdx = kmerIdx;
+    cached->count = list.count;
+    unsigned int* index = (unsigned int*) (cached + 1);
+    memcpy(index, list.index, list.count * sizeof(unsigned int));
+    memcpy(index + list.count, list.score, list.count * sizeof(short));
+
+    // the compare-and-swap is a full memory barrier, the list is written before it becomes visible to the other threads
+    size_t slot = getSlot(kmerIdx);
+    for (int i = 0; i < MAX_PROBES; i++){
+        if (slots[slot] == NULL && __sync_bool_compare_and_swap(&slots[slot], (CachedList*) NULL, cached)){
+            __sync_fetch_and_add(&listsNum, 1);
+            return;
+        }
+        // another thread added the same k-mer
+        if (slots[slot]->kmerIdx == kmerIdx)
+            break;
+        slot = (slot + 1) & (slotsNum - 1);
+    }
+    free(cached);
+    __sync_fetch_and_sub(&memory, size);
+}
+
+void KmerListCache::addStatistics(size_t hits, size_t misses){
+    __sync_fetch_and_add(&this->hits, hits);
+    __sync_fetch_and_add(&this->misses, misses);
+}
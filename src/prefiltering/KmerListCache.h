@@ -0,0 +1,77 @@
+#ifndef KMER_LIST_CACHE_H
+#define KMER_LIST_CACHE_H
+
+//
+// Cache of the similar k-mer lists of the KmerGenerator, shared by all threads.
+// The lists depend on the k-mer threshold and the substitution matrix, one cache is used for one KmerGenerator setting.
+//
+// The lists are inserted while they fit into the memory limit and are never evicted,
+// so a cached list stays valid until the cache is deleted and the threads read it without locks and without copying.
+// The hash table slots are claimed with an atomic compare-and-swap after the list is written.
+// A k-mer is not cached if all its MAX_PROBES slots are taken by other k-mers.
+//
+
+#include <cstddef>
+
+#include "KmerGenerator.h"
+
+class KmerListCache {
+
+    public:
+
+        // maxMemory: memory limit of the cached lists in byte
+        KmerListCache(size_t maxMemory);
+
+        ~KmerListCache();
+
+        // returns true and the cached list of the k-mer kmerIdx in list if the k-mer is in the cache
+        bool get(unsigned int kmerIdx, KmerGeneratorResult* list);
+
+        // copies the list of the k-mer kmerIdx into the cache if the memory limit allows it
+        void add(unsigned int kmerIdx, KmerGeneratorResult list);
+
+        // lookup counters, the threads add their counts once per query
+        void addStatistics(size_t hits, size_t misses);
+
+        size_t getHits() { return hits; }
+
+        size_t getMisses() { return misses; }
+
+        size_t getListsNum() { return listsNum; }
+
+        size_t getMemory() { return memory; }
+
+        // linear probing length of the hash table
+        static const int MAX_PROBES = 8;
+
+        // expected memory of one cached list, determines the number of hash table slots
+        static const size_t AVG_LIST_MEMORY = 1024;
+
+    private:
+
+        // header of a cached list, followed by count k-mer indexes and count scores
+        struct CachedList {
+            unsigned int kmerIdx;
+            unsigned int count;
+        };
+
+        // no insertions are tried anymore when less than the memory of an average list is left
+        static const size_t MIN_FREE_MEMORY = sizeof(CachedList) + AVG_LIST_MEMORY;
+
+        size_t getSlot(unsigned int kmerIdx);
+
+        CachedList* volatile * slots;
+        size_t slotsNum;
+        int slotBits;
+
+        size_t maxMemory;
+        volatile size_t memory;
+        volatile size_t listsNum;
+        // no insertions after less than MIN_FREE_MEMORY is left
+        volatile bool full;
+
+        volatile size_t hits;
+        volatile size_t misses;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "KmerSet.h"
+
+#include <cstring>
+
+KmerSet::KmerSet(){
+    capacityBits = 10;
+    capacity = 1 << capacityBits;
+    count = 0;
+    stamp = 1;
+    keys = new unsigned int[capacity];
+    stamps = new unsigned int[capacity];
+    memset(stamps, 0, sizeof(unsigned int) * capacity);
+}
+
+KmerSet::~KmerSet(){
+    delete[] keys;
+    delete[] stamps;
+}
+
+void KmerSet::clear(){
+    count = 0;
+    stamp++;
+    // stamp overflow: the old stamps could be mistaken for the current one
+    if (stamp == 0){
+        memset(stamps, 0, sizeof(unsigned int) * capacity);
+        stamp = 1;
+    }
+}
+
+bool KmerSet::insert(unsigned int kmerIdx){
+    size_t mask = capacity - 1;
+    size_t pos = slot(kmerIdx);
+    while (stamps[pos] == stamp){
+        if (keys[pos] == kmerIdx)
+            return false;
+        pos = (pos + 1) & mask;
+    }
+    keys[pos] = kmerIdx;
+    stamps[pos] = stamp;
+    count++;
+    // keep the load factor below 1/2
+    if (2 * count > capacity)
+        grow();
+    return true;
+}
+
+void KmerSet::grow(){
+    unsigned int* oldKeys = keys;
+    unsigned int* oldStamps = stamps;
+    size_t oldCapacity = capacity;
+
+    capacityBits++;
+    capacity = 1 << capacityBits;
+    keys = new unsigned int[capacity];
+    stamps = new unsigned int[capacity];
+    memset(stamps, 0, sizeof(unsigned int) * capacity);
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < oldCapacity; i++){
+        if (oldStamps[i] != stamp)
+            continue;
+        size_t pos = slot(oldKeys[i]);
+        while (stamps[pos] == stamp)
+            pos = (pos + 1) & mask;
+        keys[pos] = oldKeys[i];
+        stamps[pos] = stamp;
+    }
+    delete[] oldKeys;
+    delete[] oldStamps;
+}
@@ -0,0 +1,46 @@
+#ifndef KMER_SET_H
+#define KMER_SET_H
+
+//
+// Set of k-mer indices, used to add each k-mer of a sequence only once to the index table.
+// Open addressing with a stamp per slot: clearing the set between two sequences is O(1).
+//
+
+#include <cstddef>
+
+class KmerSet {
+
+    public:
+
+        KmerSet();
+
+        ~KmerSet();
+
+        // remove all k-mers from the set
+        void clear();
+
+        // returns true if the k-mer was not in the set before
+        bool insert(unsigned int kmerIdx);
+
+    private:
+
+        void grow();
+
+        // Fibonacci hashing: the upper capacityBits bits of the product are the slot
+        size_t slot(unsigned int kmerIdx) { return (kmerIdx * 2654435761U) >> (32 - capacityBits); }
+
+        unsigned int* keys;
+
+        // the slot is occupied if its stamp equals the current stamp
+        unsigned int* stamps;
+
+        size_t capacity;
+
+        int capacityBits;
+
+        size_t count;
+
+        unsigned int stamp;
+};
+
+#endif
@@ -0,0 +1,69 @@
+#include "LocalBiasCorrection.h"
+#include "../commons/Util.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <emmintrin.h>
+
+LocalBiasCorrection::LocalBiasCorrection(BaseMatrix* m){
+    this->m = m;
+    this->alphabetSize = m->alphabetSize;
+    this->paddedSize = (alphabetSize + 7) / 8 * 8;
+
+    columnScores = (short*) Util::mem_align(16, alphabetSize * paddedSize * sizeof(short));
+    memset(columnScores, 0, alphabetSize * paddedSize * sizeof(short));
+    for (int a = 0; a < alphabetSize; a++)
+        for (int b = 0; b < alphabetSize; b++)
+            columnScores[a * paddedSize + b] = m->subMatrix[b][a];
+
+    windowScores = (short*) Util::mem_align(16, paddedSize * sizeof(short));
+
+    backgroundScores = new float[alphabetSize];
+    for (int b = 0; b < alphabetSize; b++){
+        double score = 0.0;
+        for (int a = 0; a < alphabetSize; a++)
+            score += m->pBack[a] * m->subMatrix[b][a];
+        backgroundScores[b] = (float) score;
+    }
+}
+
+LocalBiasCorrection::~LocalBiasCorrection(){
+    free(columnScores);
+    free(windowScores);
+    delete[] backgroundScores;
+}
+
+void LocalBiasCorrection::calc(const int* seq, int L, float* deltaS){
+    if (L < WINDOW_SIZE + 1){
+        memset(deltaS, 0, L * sizeof(float));
+        return;
+    }
+
+    memset(windowScores, 0, paddedSize * sizeof(short));
+    __m128i* window = (__m128i*) windowScores;
+    const int blocks = paddedSize / 8;
+    // the current window is [windowStart, windowEnd)
+    int windowStart = 0;
+    int windowEnd = 0;
+    for (int i = 0; i < L; i++){
+        const int minPos = std::max(0, i - WINDOW_SIZE / 2);
+        const int maxPos = std::min(L, i + WINDOW_SIZE / 2);
+        for (; windowEnd < maxPos; windowEnd++){
+            const __m128i* column = (const __m128i*) (columnScores + seq[windowEnd] * paddedSize);
+            for (int k = 0; k < blocks; k++)
+                window[k] = _mm_add_epi16(window[k], column[k]);
+        }
+        for (; windowStart < minPos; windowStart++){
+            const __m128i* column = (const __m128i*) (columnScores + seq[windowStart] * paddedSize);
+            for (int k = 0; k < blocks; k++)
+                window[k] = _mm_sub_epi16(window[k], column[k]);
+        }
+
+        // negative mean score for the amino acids in the neighborhood of i (without i itself),
+        // positive score for the background score distribution for i
+        const int a = seq[i];
+        const int neighborhoodScore = windowScores[a] - m->subMatrix[a][a];
+        deltaS[i] = (float) neighborhoodScore / (-1.0 * (maxPos - minPos)) + backgroundScores[a];
+    }
+}
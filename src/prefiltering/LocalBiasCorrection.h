@@ -0,0 +1,50 @@
+#ifndef LOCAL_BIAS_CORRECTION_H
+#define LOCAL_BIAS_CORRECTION_H
+
+//
+// Local amino acid composition bias correction of the k-mer match scores.
+// The correction for query position i is the expected score of the residue i against the background distribution
+// minus its mean score against the other residues in a window of WINDOW_SIZE residues around i.
+//
+// The window scores of all residues are kept in one vector and updated incrementally with the columns
+// of the substitution matrix of the residues entering and leaving the window (O(L * alphabetSize / 8) SSE2 operations),
+// the background scores are computed once per matrix.
+//
+
+#include "../commons/BaseMatrix.h"
+
+class LocalBiasCorrection {
+
+    public:
+
+        LocalBiasCorrection(BaseMatrix* m);
+
+        ~LocalBiasCorrection();
+
+        // writes the correction values of the L positions of the sequence into deltaS
+        // (0 for sequences of at most WINDOW_SIZE residues)
+        void calc(const int* seq, int L, float* deltaS);
+
+        static const int WINDOW_SIZE = 40;
+
+    private:
+
+        BaseMatrix* m;
+
+        int alphabetSize;
+
+        // alphabetSize rounded up to a multiple of 8 (SSE2 vectors of 16-bit scores)
+        int paddedSize;
+
+        // columnScores[a * paddedSize + b] = subMatrix[b][a]: the scores of all residues b against the residue a
+        short* columnScores;
+
+        // scores of all residues against the residues in the current window,
+        // at most WINDOW_SIZE matrix entries each (no overflow of the 16-bit sums for matrix entries below 800)
+        short* windowScores;
+
+        // expected score of each residue against the background distribution
+        float* backgroundScores;
+};
+
+#endif
@@ -69,11 +69,31 @@ void printUsage(){
             "--max-chunk-size\t[int]\tSplits target databases in chunks when the database size exceeds the given size. (For memory saving only)\n"
             "--skip          \t[int]\tNumber of skipped k-mers during the index table generation.\n"
             "--sub-mat       \t[file]\tAmino acid substitution matrix file.\n"
+            "--index         \t[file]\tPrecomputed index table of the target database (see mmseqs_createindex).\n"
+            "--compress-index\t\tStore the sequence lists of the index table compressed (less memory, slightly slower).\n"
+            "--single-pass-index\t\tMap the target sequences only once for the index table generation (faster, needs more memory).\n"
+            "--spaced-seed   \t[str]\tSpaced k-mer pattern, e.g. 1101011 ('1': k-mer position). Sets k to the number of '1' positions.\n"
+            "--max-kmer-occ  \t[int]\tRemove k-mers occurring in more than the given number of target sequences from the index table (default=0: no limit).\n"
+            "--reorder-db    \t\tRenumber the target sequences by k-mer content for cache-local score updates (faster for large databases).\n"
+            "--query-batch   \t[int]\tNumber of queries matched together per thread, reads each sequence list of the index table once per batch (default=1).\n"
+            "                \t\tNeeds one score array per query in the batch (4 byte per target sequence).\n"
+            "--8bit-scores   \t\tSum up the k-mer match scores in 8-bit counters (half the memory of the score array, faster).\n"
+            "                \t\tThe scores saturate early, only for high sequence identity thresholds.\n"
+            "--partitioned-scores\t\tBuffer the k-mer match scores in partitions of 65536 target sequences and add them partition by partition\n"
+            "                \t\t(faster for target databases with millions of sequences and many k-mer matches per target sequence, slower for few).\n"
+            "                \t\tNeeds additional buffers of about 1 byte per target sequence for each thread and query in the batch.\n"
+            "--local-score   \t\tScore the best local region of k-mer matches along the query instead of the sum of all k-mer matches\n"
+            "                \t\t(fewer false positives for multi-domain proteins, can not be combined with --query-batch and --8bit-scores).\n"
+            "--kmer-cache    \t[int]\tMemory for caching the similar k-mer lists of k-mers repeated in the queries in MB (default=0: no cache).\n"
+            "--pipeline      \t\tRead the queries and write the results in two additional threads, the -cpu threads only match the queries\n"
+            "                \t\t(can not be combined with --query-batch).\n"
+            "--binary-output \t\tWrite the result lists in a binary format, smaller and read without parsing by mmseqs_aln (see pref2text).\n"
+            "                \t\tNeeds a target database of at most 2^32 - 1 sequences.\n"
             "-v              \t[int]\tVerbosity level: 0=NOTHING, 1=ERROR, 2=WARNING, 3=INFO (default=3).\n");
     Debug(Debug::INFO) << usage;
 }
 
-void parseArgs(int argc, const char** argv, std::string* ffindexQueryDBBase, std::string* ffindexTargetDBBase, std::string* ffindexOutDBBase, std::string* scoringMatrixFile, float* sens, int* kmerSize, int* alphabetSize, float* zscoreThr, size_t* maxSeqLen, int* seqType, size_t* maxResListLen, bool* compBiasCorrection, int* splitSize, int* threads, int* skip, int* verbosity){
+void parseArgs(int argc, const char** argv, std::string* ffindexQueryDBBase, std::string* ffindexTargetDBBase, std::string* ffindexOutDBBase, std::string* scoringMatrixFile, float* sens, int* kmerSize, int* alphabetSize, float* zscoreThr, size_t* maxSeqLen, int* seqType, size_t* maxResListLen, bool* compBiasCorrection, size_t* splitSize, int* threads, int* skip, int* verbosity, std::string* indexFile, bool* compressIndex, bool* singlePassIndex, std::string* spacedSeed, unsigned int* maxKmerOcc, bool* reorderDB, int* queryBatchSize, bool* byteScores, bool* localScore, size_t* kmerCacheSize, bool* pipeline, bool* binaryOutput, bool* partitionedScores){
     if (argc < 4){
         printUsage();
         exit(EXIT_FAILURE);
@@ -282,7 +302,98 @@ void parseArgs(int argc, const char** argv, std::string* ffindexQueryDBBase, std
         }
         else if (strcmp(argv[i], "--max-chunk-size") == 0){
             if (++i < argc){
-                *splitSize = atoi(argv[i]);
+                *splitSize = strtoull(argv[i], NULL, 10);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--reorder-db") == 0){
+            *reorderDB = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--local-score") == 0){
+            *localScore = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--kmer-cache") == 0){
+            if (++i < argc){
+                *kmerCacheSize = strtoull(argv[i], NULL, 10);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--pipeline") == 0){
+            *pipeline = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--binary-output") == 0){
+            *binaryOutput = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--8bit-scores") == 0){
+            *byteScores = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--partitioned-scores") == 0){
+            *partitionedScores = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--query-batch") == 0){
+            if (++i < argc){
+                *queryBatchSize = atoi(argv[i]);
+                if (*queryBatchSize < 1 || *queryBatchSize > 1024){
+                    Debug(Debug::ERROR) << "Please choose a query batch size in the range [1:1024].\n";
+                    exit(EXIT_FAILURE);
+                }
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--max-kmer-occ") == 0){
+            if (++i < argc){
+                *maxKmerOcc = strtoul(argv[i], NULL, 10);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--spaced-seed") == 0){
+            if (++i < argc){
+                spacedSeed->assign(argv[i]);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--single-pass-index") == 0){
+            *singlePassIndex = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--compress-index") == 0){
+            *compressIndex = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--index") == 0){
+            if (++i < argc){
+                indexFile->assign(argv[i]);
                 i++;
             }
             else {
@@ -297,6 +408,18 @@ void parseArgs(int argc, const char** argv, std::string* ffindexQueryDBBase, std
             exit(EXIT_FAILURE);
         }
     }
+    if (*localScore && (*queryBatchSize > 1 || *byteScores)){
+        Debug(Debug::ERROR) << "--local-score can not be combined with --query-batch and --8bit-scores.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (*pipeline && *queryBatchSize > 1){
+        Debug(Debug::ERROR) << "--pipeline can not be combined with --query-batch.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (*partitionedScores && (*byteScores || *localScore)){
+        Debug(Debug::ERROR) << "--partitioned-scores can not be combined with --8bit-scores and --local-score.\n";
+        exit(EXIT_FAILURE);
+    }
 }
 
 // this is needed because with GCC4.7 omp_get_num_threads() returns just 1.
@@ -321,7 +444,8 @@ int main (int argc, const char * argv[])
     size_t maxSeqLen = 50000;
     size_t maxResListLen = 300;
     float sensitivity = 4.0f;
-    int splitSize = INT_MAX;
+    // 0: no splitting of the target database
+    size_t splitSize = 0;
     int skip = 0;
     int threads = 1;
 #ifdef OPENMP
@@ -334,6 +458,20 @@ int main (int argc, const char * argv[])
     std::string queryDB = "";
     std::string targetDB = "";
     std::string outDB = "";
+    std::string indexFile = "";
+    bool compressIndex = false;
+    bool singlePassIndex = false;
+    std::string spacedSeed = "";
+    unsigned int maxKmerOcc = 0;
+    bool reorderDB = false;
+    int queryBatchSize = 1;
+    bool byteScores = false;
+    bool localScore = false;
+    // MB, 0: no k-mer list cache
+    size_t kmerCacheSize = 0;
+    bool pipeline = false;
+    bool binaryOutput = false;
+    bool partitionedScores = false;
     // get the path of the scoring matrix
     char* mmdir = getenv ("MMDIR");
     if (mmdir == 0){
@@ -352,7 +490,7 @@ int main (int argc, const char * argv[])
     parseArgs(argc, argv, &queryDB, &targetDB, &outDB, &scoringMatrixFile,
                           &sensitivity, &kmerSize, &alphabetSize, &zscoreThr,
                           &maxSeqLen, &seqType, &maxResListLen, &compBiasCorrection,
-                          &splitSize, &threads, &skip, &verbosity);
+                          &splitSize, &threads, &skip, &verbosity, &indexFile, &compressIndex, &singlePassIndex, &spacedSeed, &maxKmerOcc, &reorderDB, &queryBatchSize, &byteScores, &localScore, &kmerCacheSize, &pipeline, &binaryOutput, &partitionedScores);
 #ifdef OPENMP
     omp_set_num_threads(threads);
 #endif
@@ -361,7 +499,35 @@ int main (int argc, const char * argv[])
     if (seqType == Sequence::NUCLEOTIDES)
         alphabetSize = 5;
 
+    if (spacedSeed.length() > 0){
+        int weight = Indexer::getSpacedSeedWeight(spacedSeed);
+        if (weight < 4 || weight > 7 || spacedSeed.length() > IndexTable::MAX_SPACED_SEED_LEN){
+            Debug(Debug::ERROR) << "Invalid spaced seed " << spacedSeed << ". Please use a pattern of '0' and '1' with 4 to 7 '1' positions, "
+                << "starting and ending with '1' and at most " << IndexTable::MAX_SPACED_SEED_LEN << " characters long.\n";
+            exit(EXIT_FAILURE);
+        }
+        kmerSize = weight;
+    }
+
     Debug(Debug::WARNING) << "k-mer size: " << kmerSize << "\n";
+    if (spacedSeed.length() > 0)
+        Debug(Debug::WARNING) << "Spaced seed: " << spacedSeed << "\n";
+    if (maxKmerOcc > 0)
+        Debug(Debug::WARNING) << "Max. k-mer occurrence: " << maxKmerOcc << "\n";
+    if (queryBatchSize > 1)
+        Debug(Debug::WARNING) << "Query batch size: " << queryBatchSize << "\n";
+    if (byteScores)
+        Debug(Debug::WARNING) << "8-bit scores\n";
+    if (partitionedScores)
+        Debug(Debug::WARNING) << "Partitioned scores\n";
+    if (localScore)
+        Debug(Debug::WARNING) << "Local prefiltering score\n";
+    if (kmerCacheSize > 0)
+        Debug(Debug::WARNING) << "k-mer list cache: " << kmerCacheSize << " MB\n";
+    if (pipeline)
+        Debug(Debug::WARNING) << "Pipelined prefiltering\n";
+    if (binaryOutput)
+        Debug(Debug::WARNING) << "Binary output format\n";
     Debug(Debug::WARNING) << "Alphabet size: " << alphabetSize << "\n";
     Debug(Debug::WARNING) << "Sensitivity: " << sensitivity << "\n";
     Debug(Debug::WARNING) << "Z-score threshold: " << zscoreThr << "\n";
@@ -376,7 +542,7 @@ int main (int argc, const char * argv[])
     std::string outDBIndex = outDB + ".index";
 
     Debug(Debug::WARNING) << "Initialising data structures...\n";
-    Prefiltering* pref = new Prefiltering(queryDB, queryDBIndex, targetDB, targetDBIndex, outDB, outDBIndex, scoringMatrixFile, sensitivity, kmerSize, alphabetSize, zscoreThr, maxSeqLen, seqType, compBiasCorrection, splitSize, skip);
+    Prefiltering* pref = new Prefiltering(queryDB, queryDBIndex, targetDB, targetDBIndex, outDB, outDBIndex, scoringMatrixFile, sensitivity, kmerSize, alphabetSize, zscoreThr, maxSeqLen, seqType, compBiasCorrection, splitSize, skip, indexFile, compressIndex, singlePassIndex, spacedSeed, maxKmerOcc, reorderDB, queryBatchSize, byteScores, localScore, kmerCacheSize * 1024 * 1024, pipeline, binaryOutput, partitionedScores);
 
     gettimeofday(&end, NULL);
     int sec = end.tv_sec - start.tv_sec;
@@ -1,6 +1,9 @@
 #include "Prefiltering.h"
 #include "../commons/Util.h"
 
+#include <climits>
+#include <vector>
+
 Prefiltering::Prefiltering(std::string queryDB,
         std::string queryDBIndex,
         std::string targetDB,
@@ -15,8 +18,21 @@ Prefiltering::Prefiltering(std::string queryDB,
         size_t maxSeqLen,
         int seqType,
         bool aaBiasCorrection,
-        int splitSize,
-        int skip):    outDB(outDB),
+        size_t splitSize,
+        int skip,
+        std::string indexFile,
+        bool compressIndex,
+        bool singlePassIndex,
+        std::string spacedSeed,
+        unsigned int maxKmerOcc,
+        bool reorderDB,
+        int queryBatchSize,
+        bool byteScores,
+        bool localScore,
+        size_t kmerCacheMemory,
+        bool pipeline,
+        bool binaryOutput,
+        bool partitionedScores):    outDB(outDB),
     outDBIndex(outDBIndex),
     kmerSize(kmerSize),
     alphabetSize(alphabetSize),
@@ -25,13 +41,29 @@ Prefiltering::Prefiltering(std::string queryDB,
     seqType(seqType),
     aaBiasCorrection(aaBiasCorrection),
     splitSize(splitSize),
-    skip(skip)
+    splitFrom(0),
+    splitTo(0),
+    skip(skip),
+    compressIndex(compressIndex),
+    singlePassIndex(singlePassIndex),
+    spacedSeed(spacedSeed),
+    maxKmerOcc(maxKmerOcc),
+    reorderDB(reorderDB),
+    queryBatchSize(queryBatchSize),
+    byteScores(byteScores),
+    localScore(localScore),
+    pipeline(pipeline),
+    binaryOutput(binaryOutput),
+    partitionedScores(partitionedScores)
 {
 
     this->threads = 1;
 #ifdef OPENMP
     this->threads = omp_get_max_threads();
     Debug(Debug::INFO) << "Using " << threads << " threads.\n";
+#else
+    // the pipeline stages are threads
+    this->pipeline = false;
 #endif
     Debug(Debug::INFO) << "\n";
 
@@ -44,18 +76,18 @@ Prefiltering::Prefiltering(std::string queryDB,
     if (this->splitSize == 0)
         this->splitSize = tdbr->getSize();
 
-    std::string outDBTmp = outDB + "_tmp";
-    std::string outDBIndexTmp = outDBIndex.c_str()+std::string("_tmp");
-
-    tmpDbw = new DBWriter(outDBTmp.c_str(), outDBIndexTmp.c_str(), threads);
-    tmpDbw->open();
-
     Debug(Debug::INFO) << "Query database: " << queryDB << "(size=" << qdbr->getSize() << ")\n";
     Debug(Debug::INFO) << "Target database: " << targetDB << "(size=" << tdbr->getSize() << ")\n";
 
+    // the binary records store the target sequence ids and the database size as 32-bit integers (PrefilterFormat.h)
+    if (binaryOutput && tdbr->getSize() > UINT_MAX){
+        Debug(Debug::ERROR) << "--binary-output supports target databases with at most " << UINT_MAX << " sequences.\n";
+        exit(EXIT_FAILURE);
+    }
+
     // init the substitution matrices
     if (seqType == Sequence::AMINO_ACIDS)
-        subMat = getSubstitutionMatrix(scoringMatrixFile, 8.0);
+        subMat = getSubstitutionMatrix(scoringMatrixFile, alphabetSize, 8.0);
     else
         subMat = new NucleotideMatrix();
 
@@ -75,20 +107,54 @@ Prefiltering::Prefiltering(std::string queryDB,
         reslens[thread_idx] = new std::list<int>();
     }
 
-    outBuffers = new char*[threads];
-#pragma omp parallel for schedule(static)
-    for (int i = 0; i < threads; i++)
-        outBuffers[i] = new char[BUFFER_SIZE];
-
     // set the k-mer similarity threshold
     Debug(Debug::INFO) << "\nAdjusting k-mer similarity threshold within +-10% deviation from the reference time value, sensitivity = " << sensitivity << ")...\n";
     std::pair<short, double> ret = setKmerThreshold (tdbr, sensitivity, 0.1);
     this->kmerThr = ret.first;
     this->kmerMatchProb = ret.second;
+    // the k-mer lists depend on the threshold, the cache is created after the threshold search
+    this->kmerListCache = NULL;
+    if (kmerCacheMemory > 0)
+        this->kmerListCache = new KmerListCache(kmerCacheMemory);
 
     Debug(Debug::WARNING) << "k-mer similarity threshold: " << kmerThr << "\n";
     Debug(Debug::WARNING) << "k-mer match probability: " << kmerMatchProb << "\n\n";
 
+    // the threshold search samples the target sequences by their local ids, so the sequences are renumbered after it
+    // (also in the order stored in an index table file), otherwise --reorder-db would change the threshold and all z-scores
+    this->fileIndexTable = NULL;
+    if (indexFile.length() > 0){
+        this->fileIndexTable = openIndexTable(indexFile);
+        // the index file always covers the whole target database
+        if (this->splitSize < tdbr->getSize())
+            Debug(Debug::WARNING) << "The index table file contains the whole target database, ignoring the max. chunk size.\n";
+        this->splitSize = tdbr->getSize();
+    }
+    else if (reorderDB){
+        Debug(Debug::INFO) << "Renumbering the target sequences...\n";
+        std::vector<size_t> order = getCacheLocalOrder(tdbr, seqs, threads, alphabetSize, kmerSize, spacedSeed);
+        tdbr->setLocalIdOrder(&order[0]);
+    }
+
+    // the results of the last split are written into the output database, merged with the running lists
+    // of the previous splits (see openSplitOutput and writePrefilterOutput)
+    this->dbw = new DBWriter(outDB.c_str(), outDBIndex.c_str(), threads);
+    dbw->open();
+    this->splitDbw = NULL;
+    this->prevSplitDbr = NULL;
+
+    outBuffers = new OutputBuffer*[threads];
+    mergeBuffers = new OutputBuffer*[threads];
+    prevListReaders = new PrefilterResultReader*[threads];
+    splitListReaders = new PrefilterResultReader*[threads];
+#pragma omp parallel for schedule(static)
+    for (int i = 0; i < threads; i++){
+        outBuffers[i] = new OutputBuffer();
+        mergeBuffers[i] = new OutputBuffer();
+        prevListReaders[i] = new PrefilterResultReader(NULL);
+        splitListReaders[i] = new PrefilterResultReader(NULL);
+    }
+
     // initialise the index table and the matcher structures for the database
     // Init for next split
     this->matchers = new QueryTemplateMatcher*[threads];
@@ -97,16 +163,24 @@ Prefiltering::Prefiltering(std::string queryDB,
 Prefiltering::~Prefiltering(){
     for (int i = 0; i < threads; i++){
         delete seqs[i];
-        delete[] outBuffers[i];
+        delete outBuffers[i];
+        delete mergeBuffers[i];
+        delete prevListReaders[i];
+        delete splitListReaders[i];
         delete reslens[i];
     }
     delete[] seqs;
     delete[] outBuffers;
+    delete[] mergeBuffers;
+    delete[] prevListReaders;
+    delete[] splitListReaders;
     delete[] reslens;
 
     delete subMat;
     delete _2merSubMatrix;
     delete _3merSubMatrix;
+    delete fileIndexTable;
+    delete kmerListCache;
 }
 
 void Prefiltering::run(size_t maxResListLen){
@@ -124,22 +198,22 @@ void Prefiltering::run(size_t maxResListLen){
 
     // splits template database into chunks
     int step = 0;
-    for(unsigned int splitStart = 0; splitStart < tdbr->getSize(); splitStart += splitSize ){
+    for(size_t splitStart = 0; splitStart < tdbr->getSize(); splitStart += splitSize ){
         splitCount++;
-        std::string idSuffix;
-        std::stringstream idSuffixStream;
-        if (splitStart==0) {
-            idSuffixStream << "";
-        }else {
-            idSuffixStream << "." << splitCount;
-        }
-        idSuffix = idSuffixStream.str();
+        openSplitOutput(splitCount, splitStart + splitSize >= tdbr->getSize());
+        // the written lists include the results of the previous splits, only the lists of the last split are counted
+        realResSize = 0;
+        this->splitFrom = splitStart;
+        this->splitTo = std::min(splitStart + splitSize, tdbr->getSize());
 
 
-        Sequence* seq = new Sequence(maxSeqLen, subMat->aa2int, subMat->int2aa, seqType);
-        this->indexTable = getIndexTable(tdbr, seq, alphabetSize, kmerSize, splitStart, splitStart + splitSize , skip);
-        delete seq;
-        int stepCnt = (tdbr->getSize() + splitSize - 1) / splitSize;
+        if (fileIndexTable != NULL){
+            this->indexTable = fileIndexTable;
+        }
+        else{
+            this->indexTable = getIndexTable(tdbr, seqs, threads, alphabetSize, kmerSize, splitStart, splitStart + splitSize , skip, compressIndex, singlePassIndex, spacedSeed, getChunkMaxKmerOcc(splitSize));
+        }
+        size_t stepCnt = (tdbr->getSize() + splitSize - 1) / splitSize;
         Debug(Debug::WARNING) << "Starting prefiltering scores calculation (step " << ++step << " of " << stepCnt <<  ")\n";
 
         struct timeval start, end;
@@ -153,38 +227,63 @@ void Prefiltering::run(size_t maxResListLen){
             matchers[thread_idx] = new QueryTemplateMatcher(subMat, _2merSubMatrix, _3merSubMatrix,
                     indexTable, tdbr->getSeqLens(), kmerThr,
                     kmerMatchProb, kmerSize, tdbr->getSize(),
-                    aaBiasCorrection, maxSeqLen, zscoreThr);
+                    aaBiasCorrection, maxSeqLen, zscoreThr, queryBatchSize, byteScores, localScore, kmerListCache, partitionedScores);
         }
 
-#pragma omp parallel for schedule(dynamic, 100) reduction (+: kmersPerPos, resSize, realResSize, dbMatches)
-        for (size_t id = 0; id < queryDBSize; id++){
+        if (pipeline)
+            matchPipelined(maxResListLen, notEmpty, &kmersPerPos, &resSize, &realResSize, &dbMatches);
+        else {
+            // each thread matches blocks of queryBatchSize queries
+            const int chunkSize = std::max(1, 100 / queryBatchSize);
+#pragma omp parallel for schedule(dynamic, chunkSize) reduction (+: kmersPerPos, resSize, realResSize, dbMatches)
+            for (size_t batchStart = 0; batchStart < queryDBSize; batchStart += queryBatchSize){
 
-            Log::printProgress(id);
-
-            int thread_idx = 0;
+                int thread_idx = 0;
 #ifdef OPENMP
-            thread_idx = omp_get_thread_num();
+                thread_idx = omp_get_thread_num();
 #endif
-            // get query sequence
-            char* seqData = qdbr->getData(id);
-            seqs[thread_idx]->mapSequence(id, qdbr->getDbKey(id), seqData);
-
-            // calculate prefitlering results
-            std::pair<hit_t *, size_t> prefResults = matchers[thread_idx]->matchQuery(seqs[thread_idx], tdbr->getId(seqs[thread_idx]->getDbKey()));
-
-            const size_t resultSize = prefResults.second;
-            if(writePrefilterOutput(thread_idx, idSuffix, id, maxResListLen, prefResults) != 0)
-                continue; // couldnt write result - too many results
-
-            // update statistics counters
-            if (resultSize != 0)
-                notEmpty[id] = 1;
-            kmersPerPos += (size_t) seqs[thread_idx]->stats->kmersPerPos;
-            dbMatches += seqs[thread_idx]->stats->dbMatches;
-            resSize += resultSize;
-            realResSize += std::min(resultSize, maxResListLen);
-            reslens[thread_idx]->push_back(resultSize);
-        } // step end
+                const size_t batchEnd = std::min(batchStart + queryBatchSize, queryDBSize);
+                if (queryBatchSize > 1){
+                    for (size_t id = batchStart; id < batchEnd; id++){
+                        Log::printProgress(id);
+                        seqs[thread_idx]->mapSequence(id, qdbr->getDbKey(id), qdbr->getData(id));
+                        matchers[thread_idx]->addBatchQuery(seqs[thread_idx], getIdentityId(seqs[thread_idx]->getDbKey()));
+                    }
+                    matchers[thread_idx]->matchBatch(maxResListLen);
+                }
+
+                for (size_t id = batchStart; id < batchEnd; id++){
+                    std::pair<hit_t *, size_t> prefResults;
+                    statistics_t* stats;
+                    if (queryBatchSize > 1){
+                        prefResults = matchers[thread_idx]->getBatchResult(id - batchStart);
+                        stats = matchers[thread_idx]->getBatchStats(id - batchStart);
+                    }
+                    else {
+                        Log::printProgress(id);
+
+                        // get query sequence
+                        char* seqData = qdbr->getData(id);
+                        seqs[thread_idx]->mapSequence(id, qdbr->getDbKey(id), seqData);
+
+                        // calculate prefitlering results, only the written maxResListLen results are sorted
+                        prefResults = matchers[thread_idx]->matchQuery(seqs[thread_idx], getIdentityId(seqs[thread_idx]->getDbKey()), maxResListLen);
+                        stats = seqs[thread_idx]->stats;
+                    }
+
+                    const size_t resultSize = prefResults.second;
+                    realResSize += writePrefilterOutput(thread_idx, id, maxResListLen, prefResults);
+
+                    // update statistics counters
+                    if (resultSize != 0)
+                        notEmpty[id] = 1;
+                    kmersPerPos += (size_t) stats->kmersPerPos;
+                    dbMatches += stats->dbMatches;
+                    resSize += resultSize;
+                    reslens[thread_idx]->push_back(resultSize);
+                }
+            } // step end
+        }
         if (queryDBSize > 1000)
             Debug(Debug::INFO) << "\n";
         Debug(Debug::INFO) << "\n";
@@ -192,7 +291,9 @@ void Prefiltering::run(size_t maxResListLen){
         for (int j = 0; j < threads; j++){
             delete matchers[j];
         }
-        delete indexTable;
+        if (indexTable != fileIndexTable)
+            delete indexTable;
+        closeSplitOutput();
 
         gettimeofday(&end, NULL);
         int sec = end.tv_sec - start.tv_sec;
@@ -214,55 +315,87 @@ void Prefiltering::run(size_t maxResListLen){
     }
     // correction because of x splits
     kmersPerPos = kmersPerPos / splitCount;
-    // print statistics
-    this->printStatistics(queryDBSize, kmersPerPos, resSize, realResSize, dbMatches, empty, maxResListLen, reslens[0]);
 
     // close reader to reduce memory
-    qdbr->close();
     if (strcmp(qdbr->getIndexFileName(), tdbr->getIndexFileName()) != 0)
         tdbr->close();
 
-    // merge output ffindex databases
-    Debug(Debug::INFO) << "Merging the results...\n";
-    tmpDbw->close(); // sorts the index
-   
-    std::cout << "Threads merged...\n";
-    DBReader tmpReader(tmpDbw->getDataFileName(), tmpDbw->getIndexFileName());
-    tmpReader.open(DBReader::SORT);
+    // print statistics
+    this->printStatistics(queryDBSize, kmersPerPos, resSize, realResSize, dbMatches, empty, maxResListLen, reslens[0]);
 
-    this->dbw = new DBWriter(outDB.c_str(), outDBIndex.c_str(), 1);
-    dbw->open();
+    qdbr->close();
+    dbw->close();
+    delete dbw;
+    delete[] notEmpty;
+}
+
+void Prefiltering::openSplitOutput(int splitCount, bool lastSplit){
+    if (lastSplit)
+        return;
+    // alternates between two temporary databases, the running lists of the previous split are still read
+    std::stringstream tmpSuffix;
+    tmpSuffix << "_tmp" << (splitCount % 2);
+    std::string outDBTmp = outDB + tmpSuffix.str();
+    std::string outDBIndexTmp = outDBIndex + tmpSuffix.str();
+    splitDbw = new DBWriter(outDBTmp.c_str(), outDBIndexTmp.c_str(), threads);
+    splitDbw->open();
+}
 
-    for (size_t id = 0; id < queryDBSize; id++){
-        std::stringstream mergeResultsOut;
-        for(int split = 0; split < splitCount; split++)
-            mergeResultsOut << tmpReader.getData(id+(split*queryDBSize));
+void Prefiltering::closeSplitOutput(){
+    if (prevSplitDbr != NULL){
+        prevSplitDbr->close();
+        remove(prevSplitDbr->getDataFileName());
+        remove(prevSplitDbr->getIndexFileName());
+        delete prevSplitDbr;
+        prevSplitDbr = NULL;
+    }
+    if (splitDbw != NULL){
+        splitDbw->close(); // sorts the index
+        prevSplitDbr = new DBReader(splitDbw->getDataFileName(), splitDbw->getIndexFileName());
+        prevSplitDbr->open(DBReader::NOSORT);
+        delete splitDbw;
+        splitDbw = NULL;
+    }
+}
 
-        std::string mergeResultsOutString = mergeResultsOut.str();
-        const char* mergeResultsOutData = mergeResultsOutString.c_str();
-        if (BUFFER_SIZE < strlen(mergeResultsOutData)){
-            Debug(Debug::ERROR) << "ERROR: Buffer overflow during the merging.\n";
-            exit(EXIT_FAILURE);
+size_t Prefiltering::mergeResultLists(PrefilterResultReader* prevList, PrefilterResultReader* splitList,
+        size_t maxResListLen, OutputBuffer* out){
+    out->clear();
+    if (binaryOutput)
+        PrefilterFormat::appendHeader(out, tdbr->getSize());
+    bool hasPrev = prevList->next();
+    bool hasSplit = splitList->next();
+    size_t l = 0;
+    // The z-scores are compared at the printed precision and equal z-scores are taken from the earlier splits,
+    // so that text and binary lists are merged in the same order.
+    while (l < maxResListLen && (hasPrev || hasSplit)){
+        if (hasPrev && (!hasSplit || prevList->getPrintedZscore() >= splitList->getPrintedZscore())){
+            out->appendString(prevList->getHit(), prevList->getHitLength());
+            hasPrev = prevList->next();
         }
-        memcpy(outBuffers[0], mergeResultsOutData, mergeResultsOutString.length()*sizeof(char));
-        dbw->write(outBuffers[0], mergeResultsOutString.length(),  tmpReader.getDbKey(id), 0);
-
+        else {
+            out->appendString(splitList->getHit(), splitList->getHitLength());
+            hasSplit = splitList->next();
+        }
+        l++;
     }
-    std::cout << "Closing tmp reader...\n";
-    tmpReader.close();
-    remove(tmpDbw->getDataFileName());
-    remove(tmpDbw->getIndexFileName());
-    std::cout << "Closing dbw...\n";
-    dbw->close();
-    std::cout << "done.\n";
+    return l;
+}
 
+unsigned int Prefiltering::getIdentityId(char* queryKey){
+    const size_t id = tdbr->getId(queryKey);
+    // the other splits do not score the identity, it would be added with a zero score
+    return (id >= splitFrom && id < splitTo) ? (unsigned int) id : UINT_MAX;
 }
 
 // write prefiltering to ffindex database
-int Prefiltering::writePrefilterOutput( int thread_idx, std::string idSuffix, size_t id,
+size_t Prefiltering::writePrefilterOutput( int thread_idx, size_t id,
         size_t maxResListLen, std::pair<hit_t *, size_t> prefResults){
-    // write prefiltering results to a string
-    std::stringstream prefResultsOut;
+    // write prefiltering results to the output buffer of the thread
+    OutputBuffer* out = outBuffers[thread_idx];
+    out->clear();
+    if (binaryOutput)
+        PrefilterFormat::appendHeader(out, tdbr->getSize());
     size_t l = 0;
     hit_t * resultVector = prefResults.first;
     const size_t resultSize = prefResults.second;
@@ -274,26 +407,170 @@ int Prefiltering::writePrefilterOutput( int thread_idx, std::string idSuffix, si
             Debug(Debug::ERROR) << "Wrong prefiltering result: Query: " << qdbr->getDbKey(id)<< " -> " << res->seqId << "\t" << res->prefScore << "\n";
             continue;
         }
-        prefResultsOut << tdbr->getDbKey(res->seqId) << "\t" << res->zScore << "\t" << res->prefScore << "\n";
+        if (binaryOutput)
+            PrefilterFormat::appendRecord(out, tdbr->getGlobalId(res->seqId), res->zScore, res->prefScore);
+        else {
+            out->appendString(tdbr->getDbKey(res->seqId));
+            out->appendChar('\t');
+            out->appendFloat(res->zScore);
+            out->appendChar('\t');
+            out->appendUInt(res->prefScore);
+            out->appendChar('\n');
+        }
         l++;
         // maximum allowed result list length is reached
         if (l == maxResListLen)
             break;
     }
-    // write prefiltering results string to ffindex database
-    std::string prefResultsOutString = prefResultsOut.str();
-    const char* prefResultsOutData = prefResultsOutString.c_str();
-    if (BUFFER_SIZE < strlen(prefResultsOutData)){
-        Debug(Debug::ERROR) << "Tried to process the prefiltering list for the query " << qdbr->getDbKey(id) << " , the length of the list = " << resultSize << "\n";
-        Debug(Debug::ERROR) << "Output buffer size < prefiltering result size! (" << BUFFER_SIZE << " < " << prefResultsOutString.length() << ")\nIncrease buffer size or reconsider your parameters - output buffer is already huge ;-)\n";
-        return -1;
+    char* key = qdbr->getDbKey(id);
+    // merge with the running list of the previous splits
+    if (prevSplitDbr != NULL){
+        const size_t prevId = prevSplitDbr->getId(key);
+        if (prevId == UINT_MAX){
+            Debug(Debug::ERROR) << "Missing prefiltering results for the query " << key << " in " << prevSplitDbr->getDataFileName() << "\n";
+            exit(EXIT_FAILURE);
+        }
+        prevListReaders[thread_idx]->init(prevSplitDbr->getData(prevId), prevSplitDbr->getDataSize(prevId));
+        splitListReaders[thread_idx]->init(out->getData(), out->getLength());
+        l = mergeResultLists(prevListReaders[thread_idx], splitListReaders[thread_idx], maxResListLen, mergeBuffers[thread_idx]);
+        out = mergeBuffers[thread_idx];
+    }
+    // write prefiltering results to ffindex database
+    if (splitDbw != NULL)
+        splitDbw->write(out->getData(), out->getLength(), key, thread_idx);
+    else
+        dbw->write(out->getData(), out->getLength(), key, thread_idx);
+    return l;
+}
+
+void Prefiltering::matchPipelined(size_t maxResListLen, int* notEmpty,
+        size_t* kmersPerPos, size_t* resSize, size_t* realResSize, size_t* dbMatches){
+    const size_t queryDBSize = qdbr->getSize();
+    const int workers = threads;
+
+    // for each worker: the free slots (writer -> reader), the mapped queries (reader -> worker)
+    // and the matched queries (worker -> writer), NULL marks the end of the queries
+    // a worker has PIPELINE_SLOTS queries at most, so pushing a slot never fails
+    PipelineSlot* slots = new PipelineSlot[workers * PIPELINE_SLOTS];
+    SpscQueue<PipelineSlot*>** freeSlots = new SpscQueue<PipelineSlot*>*[workers];
+    SpscQueue<PipelineSlot*>** mapped = new SpscQueue<PipelineSlot*>*[workers];
+    SpscQueue<PipelineSlot*>** matched = new SpscQueue<PipelineSlot*>*[workers];
+    for (int w = 0; w < workers; w++){
+        freeSlots[w] = new SpscQueue<PipelineSlot*>(PIPELINE_SLOTS);
+        // one more place for the end mark
+        mapped[w] = new SpscQueue<PipelineSlot*>(PIPELINE_SLOTS + 1);
+        matched[w] = new SpscQueue<PipelineSlot*>(PIPELINE_SLOTS + 1);
+        for (int i = 0; i < PIPELINE_SLOTS; i++){
+            PipelineSlot* slot = &slots[w * PIPELINE_SLOTS + i];
+            slot->seq = new Sequence(maxSeqLen, subMat->aa2int, subMat->int2aa, seqType);
+            slot->hits = new hit_t[std::max((size_t) 1, maxResListLen)];
+            freeSlots[w]->push(slot);
+        }
     }
-    memcpy(outBuffers[thread_idx], prefResultsOutData, prefResultsOutString.length()*sizeof(char));
-    std::stringstream keyStream;
-    keyStream << qdbr->getDbKey(id) << idSuffix;
-    tmpDbw->write(outBuffers[thread_idx], prefResultsOutString.length(), (char *) keyStream.str().c_str() , thread_idx);
-    return 0;
 
+    size_t kmersPerPosSum = 0;
+    size_t dbMatchesSum = 0;
+    size_t resSizeSum = 0;
+    size_t realResSizeSum = 0;
+
+#pragma omp parallel num_threads(workers + 2)
+    {
+        int thread_idx = 0;
+        int threadsNum = 1;
+#ifdef OPENMP
+        thread_idx = omp_get_thread_num();
+        threadsNum = omp_get_num_threads();
+#endif
+        if (threadsNum < workers + 2){
+            if (thread_idx == 0){
+                Debug(Debug::ERROR) << "The prefiltering pipeline needs " << (workers + 2) << " threads, got only " << threadsNum << ".\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (thread_idx == 0){
+            // reader: maps the queries into the free slots, a worker with free slots gets the next query
+            int w = 0;
+            for (size_t id = 0; id < queryDBSize; id++){
+                Log::printProgress(id);
+                PipelineSlot* slot = NULL;
+                for (int rounds = 0; ; rounds++){
+                    for (int i = 0; i < workers && slot == NULL; i++){
+                        w = (w + 1) % workers;
+                        freeSlots[w]->pop(&slot);
+                    }
+                    if (slot != NULL)
+                        break;
+                    SpscQueue<PipelineSlot*>::idle(rounds);
+                }
+                slot->seq->mapSequence(id, qdbr->getDbKey(id), qdbr->getData(id));
+                mapped[w]->push(slot);
+            }
+            for (int i = 0; i < workers; i++)
+                mapped[i]->waitPush(NULL);
+        }
+        else if (thread_idx == 1){
+            // writer: formats and writes the results in the order the workers finish them
+            int finished = 0;
+            int rounds = 0;
+            while (finished < workers){
+                bool written = false;
+                for (int w = 0; w < workers; w++){
+                    PipelineSlot* slot;
+                    if (!matched[w]->pop(&slot))
+                        continue;
+                    written = true;
+                    if (slot == NULL){
+                        finished++;
+                        continue;
+                    }
+                    const size_t id = slot->seq->getId();
+                    realResSizeSum += writePrefilterOutput(0, id, maxResListLen, std::make_pair(slot->hits, slot->hitsNum));
+                    if (slot->resultSize != 0)
+                        notEmpty[id] = 1;
+                    kmersPerPosSum += (size_t) slot->seq->stats->kmersPerPos;
+                    dbMatchesSum += slot->seq->stats->dbMatches;
+                    resSizeSum += slot->resultSize;
+                    reslens[0]->push_back(slot->resultSize);
+                    freeSlots[w]->push(slot);
+                }
+                rounds = written ? 0 : rounds + 1;
+                if (!written)
+                    SpscQueue<PipelineSlot*>::idle(rounds);
+            }
+        }
+        else {
+            // worker: matches the queries with its own matcher and copies the results into the slot
+            const int w = thread_idx - 2;
+            PipelineSlot* slot;
+            for (mapped[w]->waitPop(&slot); slot != NULL; mapped[w]->waitPop(&slot)){
+                std::pair<hit_t *, size_t> prefResults = matchers[w]->matchQuery(slot->seq, getIdentityId(slot->seq->getDbKey()), maxResListLen);
+                slot->resultSize = prefResults.second;
+                slot->hitsNum = std::min(prefResults.second, maxResListLen);
+                memcpy(slot->hits, prefResults.first, slot->hitsNum * sizeof(hit_t));
+                matched[w]->push(slot);
+            }
+            matched[w]->push(NULL);
+        }
+    }
+
+    *kmersPerPos += kmersPerPosSum;
+    *dbMatches += dbMatchesSum;
+    *resSize += resSizeSum;
+    *realResSize += realResSizeSum;
+
+    for (int i = 0; i < workers * PIPELINE_SLOTS; i++){
+        delete slots[i].seq;
+        delete[] slots[i].hits;
+    }
+    for (int w = 0; w < workers; w++){
+        delete freeSlots[w];
+        delete mapped[w];
+        delete matched[w];
+    }
+    delete[] slots;
+    delete[] freeSlots;
+    delete[] mapped;
+    delete[] matched;
 }
 
 
@@ -305,6 +582,11 @@ void Prefiltering::printStatistics(size_t queryDBSize, size_t kmersPerPos,
     size_t prefPassedPerSeq = resSize/queryDBSize;
     size_t prefRealPassedPerSeq = realResSize/queryDBSize;
     Debug(Debug::WARNING) << kmersPerPos/queryDBSize << " k-mers per position.\n";
+    if (kmerListCache != NULL){
+        const size_t lookups = std::max((size_t) 1, kmerListCache->getHits() + kmerListCache->getMisses());
+        Debug(Debug::WARNING) << "k-mer list cache: " << (100.0 * kmerListCache->getHits() / lookups) << "% hits, "
+            << kmerListCache->getListsNum() << " lists, " << (kmerListCache->getMemory() >> 20) << " MB.\n";
+    }
     Debug(Debug::WARNING) << dbMatchesPerSeq << " DB matches per sequence.\n";
     Debug(Debug::WARNING) << prefPassedPerSeq << " sequences passed prefiltering per query sequence";
     if (prefPassedPerSeq > maxResListLen)
@@ -320,7 +602,7 @@ void Prefiltering::printStatistics(size_t queryDBSize, size_t kmersPerPos,
     Debug(Debug::INFO) << empty << " sequences with 0 size result lists.\n";
 }
 
-BaseMatrix* Prefiltering::getSubstitutionMatrix(std::string scoringMatrixFile, float bitFactor){
+BaseMatrix* Prefiltering::getSubstitutionMatrix(std::string scoringMatrixFile, int alphabetSize, float bitFactor){
     Debug(Debug::INFO) << "Substitution matrices...\n";
     BaseMatrix* subMat;
     if (alphabetSize < 21){
@@ -333,59 +615,291 @@ BaseMatrix* Prefiltering::getSubstitutionMatrix(std::string scoringMatrixFile, f
     return subMat;
 }
 
+unsigned int Prefiltering::getMatrixHash(BaseMatrix* subMat){
+    unsigned int hash = Util::fnvHash(&subMat->alphabetSize, sizeof(int));
+    hash = Util::fnvHash(subMat->int2aa, subMat->alphabetSize * sizeof(char), hash);
+    for (int i = 0; i < subMat->alphabetSize; i++)
+        hash = Util::fnvHash(subMat->subMatrix[i], subMat->alphabetSize * sizeof(short), hash);
+    return hash;
+}
 
-IndexTable* Prefiltering::getIndexTable (DBReader* dbr, Sequence* seq, int alphabetSize,
-        int kmerSize, size_t dbFrom, size_t dbTo, int skip){
+unsigned int Prefiltering::getDBHash(DBReader* dbr){
+    size_t dbSize = dbr->getSize();
+    unsigned int hash = Util::fnvHash(&dbSize, sizeof(size_t));
+    return Util::fnvHash(dbr->getSeqLens(), dbSize * sizeof(unsigned short), hash);
+}
+
+IndexTable* Prefiltering::openIndexTable(std::string indexFile){
+    Debug(Debug::INFO) << "Index table: mapping " << indexFile << "...\n";
+    IndexTable* indexTable = new IndexTable(indexFile.c_str());
+    index_header_t* h = indexTable->getHeader();
+    if (h->kmerSize != kmerSize || h->alphabetSize != alphabetSize || h->skip != skip){
+        Debug(Debug::ERROR) << "The index table " << indexFile << " was created with k = " << h->kmerSize
+            << ", alphabet size = " << h->alphabetSize << ", skip = " << h->skip
+            << ", but the prefiltering uses k = " << kmerSize << ", alphabet size = " << alphabetSize << ", skip = " << skip << ".\n";
+        exit(EXIT_FAILURE);
+    }
+    if (indexTable->getSpacedSeed() != spacedSeed){
+        Debug(Debug::ERROR) << "The index table " << indexFile << " was created with the spaced seed \"" << indexTable->getSpacedSeed()
+            << "\", but the prefiltering uses \"" << spacedSeed << "\".\n";
+        exit(EXIT_FAILURE);
+    }
+    if (h->maxKmerOcc != maxKmerOcc){
+        Debug(Debug::ERROR) << "The index table " << indexFile << " was created with max. k-mer occurrence = " << h->maxKmerOcc
+            << ", but the prefiltering uses " << maxKmerOcc << ".\n";
+        exit(EXIT_FAILURE);
+    }
+    if (reorderDB && indexTable->getSeqOrder() == NULL){
+        Debug(Debug::ERROR) << "The index table " << indexFile << " was created without renumbering the target sequences, please recreate it with --reorder-db.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (h->matrixHash != getMatrixHash(subMat)){
+        Debug(Debug::ERROR) << "The index table " << indexFile << " was created with a different substitution matrix.\n";
+        exit(EXIT_FAILURE);
+    }
+    if (h->dbSize != tdbr->getSize()){
+        Debug(Debug::ERROR) << "The index table " << indexFile << " was created for a different target database.\n";
+        exit(EXIT_FAILURE);
+    }
+    // the sequence ids in the index table refer to the target sequence order stored in the file
+    if (indexTable->getSeqOrder() != NULL){
+        std::vector<size_t> order(indexTable->getSeqOrder(), indexTable->getSeqOrder() + indexTable->getSeqOrderSize());
+        tdbr->setLocalIdOrder(&order[0]);
+    }
+    if (h->dbHash != getDBHash(tdbr)){
+        Debug(Debug::ERROR) << "The index table " << indexFile << " was created for a different target database.\n";
+        exit(EXIT_FAILURE);
+    }
+    Debug(Debug::INFO) << "Index table: " << h->tableEntriesNum << " entries.\n\n";
+    return indexTable;
+}
+
+
+static size_t findRoot(std::vector<size_t>& parent, size_t id){
+    while (parent[id] != id){
+        parent[id] = parent[parent[id]];
+        id = parent[id];
+    }
+    return id;
+}
+
+std::vector<size_t> Prefiltering::getCacheLocalOrder(DBReader* dbr, Sequence** seqs, int threads, int alphabetSize, int kmerSize, std::string spacedSeed){
+    size_t dbSize = dbr->getSize();
+    Indexer** idxers = new Indexer*[threads];
+    for (int i = 0; i < threads; i++)
+        idxers[i] = new Indexer(alphabetSize, kmerSize, spacedSeed);
+    int seedSpan = idxers[0]->getSeedSpan();
+
+    // min-hash sketch of each sequence: the smallest value of MINHASH_NUM different hash functions over its features
+    // a feature is a pair of overlapping k-mers (i, i + span / 2): single k-mers are shared by chance between unrelated sequences
+    // in large databases, that would join them into few huge groups
+    std::vector<unsigned int> sketches(dbSize * MINHASH_NUM);
+    std::vector<unsigned int>* kmers = new std::vector<unsigned int>[threads];
+#pragma omp parallel for schedule(dynamic, 100)
+    for (size_t id = 0; id < dbSize; id++){
+        int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = omp_get_thread_num();
+#endif
+        char* seqData = dbr->getData(id);
+        Sequence* s = seqs[thread_idx];
+        s->mapSequence(id, dbr->getDbKey(id), seqData);
+        idxers[thread_idx]->reset();
+        std::vector<unsigned int>& seqKmers = kmers[thread_idx];
+        seqKmers.clear();
+        while (s->hasNextKmer(seedSpan))
+            seqKmers.push_back(idxers[thread_idx]->getNextKmerIndex(s->nextKmer(seedSpan), kmerSize));
+        unsigned int* sketch = &sketches[id * MINHASH_NUM];
+        for (int h = 0; h < MINHASH_NUM; h++)
+            sketch[h] = UINT_MAX;
+        for (size_t i = 0; i + seedSpan / 2 < seqKmers.size(); i++){
+            unsigned long long feature = ((unsigned long long) seqKmers[i] << 32) | seqKmers[i + seedSpan / 2];
+            for (int h = 0; h < MINHASH_NUM; h++){
+                // murmur3 64 bit finalizer with a different seed for each hash function
+                unsigned long long x = feature + h * 0x9E3779B97F4A7C15ULL;
+                x ^= x >> 33;
+                x *= 0xFF51AFD7ED558CCDULL;
+                x ^= x >> 33;
+                x *= 0xC4CEB9FE1A85EC53ULL;
+                x ^= x >> 33;
+                sketch[h] = std::min(sketch[h], (unsigned int) (x >> 32));
+            }
+        }
+    }
+    for (int i = 0; i < threads; i++)
+        delete idxers[i];
+    delete[] idxers;
+    delete[] kmers;
+
+    // sequences sharing one of the min-hash values are put into the same group (union-find, the smallest id is the root)
+    std::vector<size_t> parent(dbSize);
+    for (size_t id = 0; id < dbSize; id++)
+        parent[id] = id;
+    std::vector<std::pair<unsigned int, size_t> > hashes(dbSize);
+    for (int h = 0; h < MINHASH_NUM; h++){
+        for (size_t id = 0; id < dbSize; id++)
+            hashes[id] = std::make_pair(sketches[id * MINHASH_NUM + h], id);
+        std::sort(hashes.begin(), hashes.end());
+        for (size_t i = 1; i < dbSize; i++){
+            // sequences too short for a feature have no sketch
+            if (hashes[i].first != hashes[i-1].first || hashes[i].first == UINT_MAX)
+                continue;
+            size_t root1 = findRoot(parent, hashes[i-1].second);
+            size_t root2 = findRoot(parent, hashes[i].second);
+            parent[std::max(root1, root2)] = std::min(root1, root2);
+        }
+    }
+
+    size_t groups = 0;
+    size_t groupedSeqs = 0;
+    std::vector<size_t> groupSizes(dbSize, 0);
+    for (size_t id = 0; id < dbSize; id++)
+        groupSizes[findRoot(parent, id)]++;
+    for (size_t id = 0; id < dbSize; id++){
+        if (groupSizes[id] > 1){
+            groups++;
+            groupedSeqs += groupSizes[id];
+        }
+    }
+    Debug(Debug::INFO) << groupedSeqs << " sequences in " << groups << " groups sharing k-mers.\n";
+
+    // the length bins start where the length drops below 90% of the first length of the bin, as the steps in QueryScore
+    // within a bin the sequences of a group get consecutive ids
+    unsigned short* seqLens = dbr->getSeqLens();
+    std::vector<size_t> order(dbSize);
+    std::vector<std::pair<size_t, size_t> > bin;
+    size_t binStart = 0;
+    for (size_t id = 0; id <= dbSize; id++){
+        if (id == dbSize || (float) seqLens[id] / (float) seqLens[binStart] < 0.9){
+            std::sort(bin.begin(), bin.end());
+            for (size_t i = 0; i < bin.size(); i++)
+                order[binStart + i] = bin[i].second;
+            bin.clear();
+            binStart = id;
+        }
+        if (id < dbSize)
+            bin.push_back(std::make_pair(findRoot(parent, id), id));
+    }
+    return order;
+}
+
+IndexTable* Prefiltering::getIndexTable (DBReader* dbr, Sequence** seqs, int threads, int alphabetSize,
+        int kmerSize, size_t dbFrom, size_t dbTo, int skip, bool compress, bool singlePass, std::string spacedSeed, unsigned int maxKmerOcc){
 
     struct timeval start, end;
     gettimeofday(&start, NULL);
 
+    // one Indexer per thread, the k-mer counters and list positions in the index table are updated atomically
+    Indexer** idxers = new Indexer*[threads];
+    KmerSet** kmerSets = new KmerSet*[threads];
+    for (int i = 0; i < threads; i++){
+        idxers[i] = new Indexer(alphabetSize, kmerSize, spacedSeed);
+        kmerSets[i] = new KmerSet();
+    }
+
     Debug(Debug::INFO) << "Index table: counting k-mers...\n";
     // fill and init the index table
-    IndexTable* indexTable = new IndexTable(alphabetSize, kmerSize, skip);
+    IndexTable* indexTable = new IndexTable(alphabetSize, kmerSize, skip, spacedSeed);
     dbTo=std::min(dbTo,dbr->getSize());
-    for (unsigned int id = dbFrom; id < dbTo; id++){
+    // single pass mode: per thread sequence of (sequence id, number of k-mers, k-mer indices) records
+    std::vector<unsigned int>* kmerCaches = new std::vector<unsigned int>[threads];
+#pragma omp parallel for schedule(dynamic, 100)
+    for (size_t id = dbFrom; id < dbTo; id++){
         Log::printProgress(id-dbFrom);
+        int thread_idx = 0;
+#ifdef OPENMP
+        thread_idx = omp_get_thread_num();
+#endif
         char* seqData = dbr->getData(id);
-        std::string str(seqData);
-        seq->mapSequence(id, dbr->getDbKey(id), seqData);
-        indexTable->addKmerCount(seq);
+        seqs[thread_idx]->mapSequence(id, dbr->getDbKey(id), seqData);
+        indexTable->addKmerCount(seqs[thread_idx], idxers[thread_idx], kmerSets[thread_idx], (singlePass ? &kmerCaches[thread_idx] : NULL));
     }
 
     if ((dbTo-dbFrom) > 10000)
         Debug(Debug::INFO) << "\n";
     Debug(Debug::INFO) << "Index table: init... from "<< dbFrom << " to "<< dbTo << "\n";
+    Debug(Debug::INFO) << "Index table: " << indexTable->getTableEntriesNum() << " entries, "
+        << indexTable->getDuplicateKmerCount() << " repeated k-mers within sequences skipped ("
+        << indexTable->getDuplicateKmerCount() * sizeof(int) / 1024 / 1024 << " MB saved).\n";
+    if (maxKmerOcc > 0){
+        int64_t entriesNum = indexTable->getTableEntriesNum();
+        indexTable->maskFrequentKmers(maxKmerOcc);
+        Debug(Debug::INFO) << "Index table: " << indexTable->getMaskedKmerCount() << " k-mers occurring in more than " << maxKmerOcc
+            << " sequences masked (" << entriesNum - indexTable->getTableEntriesNum() << " entries removed).\n";
+    }
     indexTable->init();
 
     Debug(Debug::INFO) << "Index table: fill...\n";
-    for (unsigned int id = dbFrom; id < dbTo; id++){
-        Log::printProgress(id-dbFrom);
-        char* seqData = dbr->getData(id);
-        std::string str(seqData);
-        seq->mapSequence(id, dbr->getDbKey(id), seqData);
-        indexTable->addSequence(seq);
+    if (singlePass){
+        // the caches of the threads have roughly the same size because of the dynamic scheduling in the counting pass
+#pragma omp parallel for schedule(dynamic, 1)
+        for (int t = 0; t < threads; t++){
+            if (kmerCaches[t].empty())
+                continue;
+            const unsigned int* it = &kmerCaches[t][0];
+            const unsigned int* end = it + kmerCaches[t].size();
+            while (it < end)
+                it += indexTable->addSequence(it);
+            // release the cache memory before the duplicate removal
+            std::vector<unsigned int>().swap(kmerCaches[t]);
+        }
+    }
+    else {
+#pragma omp parallel for schedule(dynamic, 100)
+        for (size_t id = dbFrom; id < dbTo; id++){
+            Log::printProgress(id-dbFrom);
+            int thread_idx = 0;
+#ifdef OPENMP
+            thread_idx = omp_get_thread_num();
+#endif
+            char* seqData = dbr->getData(id);
+            seqs[thread_idx]->mapSequence(id, dbr->getDbKey(id), seqData);
+            indexTable->addSequence(seqs[thread_idx], idxers[thread_idx], kmerSets[thread_idx]);
+        }
+        if ((dbTo-dbFrom) > 10000)
+            Debug(Debug::INFO) << "\n";
     }
+    delete[] kmerCaches;
 
-    if ((dbTo-dbFrom) > 10000)
-        Debug(Debug::INFO) << "\n";
-    Debug(Debug::INFO) << "Index table: removing duplicate entries...\n";
-    indexTable->removeDuplicateEntries();
+    Debug(Debug::INFO) << "Index table: sorting the sequence lists...\n";
+    indexTable->sortEntries();
+    if (compress){
+        Debug(Debug::INFO) << "Index table: compressing...\n";
+        indexTable->compress();
+    }
     Debug(Debug::INFO) << "Index table init done.\n\n";
 
+    for (int i = 0; i < threads; i++){
+        delete idxers[i];
+        delete kmerSets[i];
+    }
+    delete[] idxers;
+    delete[] kmerSets;
+
     gettimeofday(&end, NULL);
     int sec = end.tv_sec - start.tv_sec;
     Debug(Debug::WARNING) << "Time for index table init: " << (sec / 3600) << " h " << (sec % 3600 / 60) << " m " << (sec % 60) << "s\n\n\n";
     return indexTable;
 }
 
+unsigned int Prefiltering::getChunkMaxKmerOcc(size_t chunkSize){
+    if (maxKmerOcc == 0 || chunkSize >= tdbr->getSize())
+        return maxKmerOcc;
+    // the limit refers to the whole target database, a chunk with a fraction of the sequences gets the same fraction of the limit
+    return std::max((size_t) 1, (size_t) maxKmerOcc * chunkSize / tdbr->getSize());
+}
+
 std::pair<short,double> Prefiltering::setKmerThreshold (DBReader* dbr, double sensitivity, double toleratedDeviation){
 
+    // the test runs use a small index of the first sequences, also if an index table file is mapped:
+    // matching the test queries against the whole database would take longer than the run
+    // and give a different threshold than a run without the index file
     size_t targetDbSize = std::min( dbr->getSize(), (size_t) 100000);
-    IndexTable* indexTable = getIndexTable(dbr, seqs[0], alphabetSize, kmerSize, 0, targetDbSize);
+    IndexTable* indexTable = getIndexTable(dbr, seqs, threads, alphabetSize, kmerSize, 0, targetDbSize, 0, compressIndex, singlePassIndex, spacedSeed, getChunkMaxKmerOcc(targetDbSize));
 
     QueryTemplateMatcher** matchers = new QueryTemplateMatcher*[threads];
 
-    int targetSeqLenSum = 0;
+    size_t targetSeqLenSum = 0;
     for (size_t i = 0; i < targetDbSize; i++)
         targetSeqLenSum += dbr->getSeqLens()[i];
 
@@ -15,6 +15,10 @@
 #include "../commons/NucleotideMatrix.h"
 #include "../commons/Debug.h"
 #include "../commons/Log.h"
+#include "../commons/SpscQueue.h"
+#include "../commons/OutputBuffer.h"
+#include "../commons/PrefilterFormat.h"
+#include "../commons/PrefilterResultReader.h"
 #include "ExtendedSubstitutionMatrix.h"
 #include "ReducedMatrix.h"
 #include "KmerGenerator.h"
@@ -42,33 +46,93 @@ class Prefiltering {
                 size_t maxSeqLen, 
                 int seqType, 
                 bool aaBiasCorrection,
-                int splitSize,
-                int skip);
+                size_t splitSize,
+                int skip,
+                std::string indexFile = "",
+                bool compressIndex = false,
+                bool singlePassIndex = false,
+                std::string spacedSeed = "",
+                unsigned int maxKmerOcc = 0,
+                bool reorderDB = false,
+                int queryBatchSize = 1,
+                bool byteScores = false,
+                bool localScore = false,
+                size_t kmerCacheMemory = 0,
+                bool pipeline = false,
+                bool binaryOutput = false,
+                bool partitionedScores = false);
 
         ~Prefiltering();
 
         void run (size_t maxResListLen);
 
-        static IndexTable* getIndexTable(DBReader* dbr, Sequence* seq, int alphabetSize, int kmerSize, size_t dbFrom, size_t dbTo, int skip = 0);
+        // builds the index table using one Sequence object per thread
+        // compress: store the sequence lists delta encoded and bit-packed
+        // singlePass: keep the k-mer indices of the counting pass in memory instead of mapping the sequences a second time
+        // (faster, but needs about as much additional memory as the sequence lists)
+        // spacedSeed: pattern of the k-mer positions, empty for contiguous k-mers (see Indexer)
+        // maxKmerOcc: k-mers occurring in more than maxKmerOcc sequences are removed from the index table, 0: no limit
+        static IndexTable* getIndexTable(DBReader* dbr, Sequence** seqs, int threads, int alphabetSize, int kmerSize, size_t dbFrom, size_t dbTo, int skip = 0, bool compress = false, bool singlePass = false, std::string spacedSeed = "", unsigned int maxKmerOcc = 0);
+
+        // renumbers the target sequences for cache-local score updates in QueryScore
+        // the sequences stay sorted by length in bins of 90% length (the steps of the score thresholds in QueryScore),
+        // within a bin, groups of sequences sharing one of the smallest hash values of their k-mer pairs (min-hash) get consecutive ids,
+        // so the ids in the sequence lists of the index table are clustered
+        // returns the order for DBReader::setLocalIdOrder
+        static std::vector<size_t> getCacheLocalOrder(DBReader* dbr, Sequence** seqs, int threads, int alphabetSize, int kmerSize, std::string spacedSeed = "");
+
+        static BaseMatrix* getSubstitutionMatrix(std::string scoringMatrixFile, int alphabetSize, float bitFactor);
+
+        // fingerprints stored in the index table file to detect an index that does not fit to the prefiltering run
+        static unsigned int getMatrixHash(BaseMatrix* subMat);
+
+        static unsigned int getDBHash(DBReader* dbr);
 
     private:
-        static const size_t BUFFER_SIZE = 1000000;
+        // number of queries of one worker thread in the pipeline (see matchPipelined)
+        static const int PIPELINE_SLOTS = 16;
+
+        // one query in the pipeline: mapped by the reader thread, matched by a worker thread and written by the writer thread
+        // (the matcher statistics of the query are in seq->stats)
+        struct PipelineSlot {
+            Sequence* seq;
+            // copy of the written results, the matcher overwrites its result list with the next query
+            hit_t* hits;
+            size_t hitsNum;
+            // number of results before the maxResListLen cut
+            size_t resultSize;
+        };
+
+        // number of hash functions for the k-mer content grouping in getCacheLocalOrder
+        static const int MINHASH_NUM = 8;
 
         int threads;
 
         DBReader* qdbr;
         DBReader* tdbr;
         DBWriter* dbw;
-        DBWriter* tmpDbw;
+        // if the target database is split, the result lists of the splits matched so far are merged into one running list
+        // per query after each split (see writePrefilterOutput), so at most two temporary databases exist at a time:
+        // the running lists of the current split (NULL for the last split, it writes into dbw)
+        DBWriter* splitDbw;
+        // and the running lists of the previous splits (NULL for the first split)
+        DBReader* prevSplitDbr;
 
         Sequence** seqs;
         std::list<int>** reslens;
         BaseMatrix* subMat;
         ExtendedSubstitutionMatrix* _2merSubMatrix;
         ExtendedSubstitutionMatrix* _3merSubMatrix;
-        char** outBuffers;
+        // result lists and the lists merged with the running lists of the previous splits, one per thread
+        OutputBuffer** outBuffers;
+        OutputBuffer** mergeBuffers;
+        // readers of the running lists of the previous splits and of the lists of the current split, one per thread
+        PrefilterResultReader** prevListReaders;
+        PrefilterResultReader** splitListReaders;
         QueryTemplateMatcher** matchers;
         IndexTable* indexTable;
+        // index table mapped from the file given by the user, used for all splits
+        IndexTable* fileIndexTable;
 
         std::string outDB;
         std::string outDBIndex;
@@ -81,16 +145,64 @@ class Prefiltering {
         bool aaBiasCorrection;
         short kmerThr;
         double kmerMatchProb;
-        int splitSize;
+        size_t splitSize;
+        // local ids of the target sequences in the current split
+        size_t splitFrom;
+        size_t splitTo;
         int skip;
-        BaseMatrix* getSubstitutionMatrix(std::string scoringMatrixFile, float bitFactor);
+        bool compressIndex;
+        bool singlePassIndex;
+        std::string spacedSeed;
+        unsigned int maxKmerOcc;
+        bool reorderDB;
+        // number of queries matched together against the index table by one thread (see QueryTemplateMatcher::matchBatch)
+        int queryBatchSize;
+        // 8-bit score counters (QueryScoreGlobal8)
+        bool byteScores;
+        // local score along the query (QueryScoreSemiLocal)
+        bool localScore;
+        // cache of the similar k-mer lists for the k-mer threshold of the run, shared by all matchers (NULL: no cache)
+        KmerListCache* kmerListCache;
+        // separate reader and writer threads (matchPipelined)
+        bool pipeline;
+        // write the result lists in the binary format (see PrefilterFormat)
+        bool binaryOutput;
+        // buffer the score updates in partitions of the target sequences (QueryScorePartitioned)
+        bool partitionedScores;
+
+        // limit of the sequence list lengths for an index table of chunkSize target sequences
+        unsigned int getChunkMaxKmerOcc(size_t chunkSize);
+
+        // map the index table file and check if it was created with the same parameters
+        IndexTable* openIndexTable(std::string indexFile);
 
         /* Set the k-mer similarity threshold that regulates the length of k-mer lists for each k-mer in the query sequence.
          * As a result, the prefilter always has roughly the same speed for different k-mer and alphabet sizes.
          */
         std::pair<short,double> setKmerThreshold(DBReader* dbr, double targetKmerMatchProb, double toleratedDeviation);
         // write prefiltering to ffindex database
-        int writePrefilterOutput( int thread_idx, std::string idSuffix, size_t id, size_t maxResListLen, std::pair<hit_t *,size_t> prefResults);
+        // returns the number of results written for the query, including the merged results of the previous splits
+        size_t writePrefilterOutput( int thread_idx, size_t id, size_t maxResListLen, std::pair<hit_t *,size_t> prefResults);
+
+        // matches all queries against the current index table in a pipeline of threads (queryBatchSize 1):
+        // one thread maps the queries, the matchers run in this->threads worker threads (-cpu) and one thread writes the results,
+        // connected by bounded lock-free queues, so the matchers never wait for the formatting and the writing of the results
+        void matchPipelined(size_t maxResListLen, int* notEmpty,
+                size_t* kmersPerPos, size_t* resSize, size_t* realResSize, size_t* dbMatches);
+
+        // local id of the query sequence in the target database for the identity hit,
+        // UINT_MAX if it is not in the database or not in the current split
+        unsigned int getIdentityId(char* queryKey);
+
+        // opens splitDbw for the running lists of the split splitCount, unless it is the last split
+        void openSplitOutput(int splitCount, bool lastSplit);
+
+        // after a split: removes the running lists of the previous splits and opens those of the split for reading
+        void closeSplitOutput();
+
+        // merges the running list of the previous splits and the list of the current split, both sorted by z-score,
+        // into out and cuts it at maxResListLen, returns the number of merged results
+        size_t mergeResultLists(PrefilterResultReader* prevList, PrefilterResultReader* splitList, size_t maxResListLen, OutputBuffer* out);
 
         void printStatistics(size_t queryDBSize, size_t kmersPerPos, size_t resSize, size_t realResSize, size_t dbMatches,
                 int empty, size_t maxResListLen, std::list<int>* reslens);
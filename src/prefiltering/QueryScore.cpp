@@ -1,35 +1,43 @@
 #include "QueryScore.h"
 #include "../commons/Util.h"
-#define CHECK_BIT(var,pos) ((var) & (1<<(pos)))
+
+#include <immintrin.h>
+
 #define _mm_extract_epi32(x, imm) _mm_cvtsi128_si32(_mm_srli_si128((x), 4 * (imm)))
 #define _mm_extract_epi64(x, imm) _mm_cvtsi128_si64(_mm_srli_si128((x), 8 * (imm)))
 
-QueryScore::QueryScore (int dbSize, unsigned short * dbSeqLens, int k, short kmerThr, float kmerMatchProb, float zscoreThr){
+QueryScore::QueryScore (size_t dbSize, unsigned short * dbSeqLens, int k, short kmerThr, float kmerMatchProb, float zscoreThr, bool byteScores){
 
     this->dbSize = dbSize;
     this->kmerMatchProb = kmerMatchProb;
     this->kmerThr = kmerThr;
     this->zscore_thr = zscoreThr;
+    this->kmerScoreShift = byteScores ? KMER_SCORE_SHIFT_8BIT : KMER_SCORE_SHIFT;
 
     this->scores_128_size = (dbSize + 7)/8 * 8;
     // 8 DB short int entries are stored in one __m128i vector
     // one __m128i vector needs 16 byte
-    scores_128 = (__m128i*) Util::mem_align(16, scores_128_size * 2);
-    scores = (unsigned short * ) scores_128;
+    // aligned to the cache lines (and the AVX-512 vectors)
+    // 8-bit scores: one __m128i vector holds 16 entries
+    const size_t scoreBytes = byteScores ? 1 : 2;
+    scores_128 = (__m128i*) Util::mem_align(64, scores_128_size * scoreBytes);
+    if (byteScores){
+        scores = NULL;
+        scores8 = (unsigned char *) scores_128;
+    }
+    else {
+        scores = (unsigned short * ) scores_128;
+        scores8 = NULL;
+    }
 
     // set scores to zero
-    memset (scores_128, 0, scores_128_size * 2);
-
-    thresholds_128 = (__m128i*) Util::mem_align(16, scores_128_size * 2);
-    thresholds = (unsigned short * ) thresholds_128;
-
-    memset (thresholds_128, 0, scores_128_size * 2);
+    memset (scores_128, 0, scores_128_size * scoreBytes);
 
     // initialize sequence lenghts with each seqLens[i] = L_i - k + 1
     this->seqLens = new float[scores_128_size];
     memset (seqLens, 0, scores_128_size * 4);
 
-    for (int i = 0; i < dbSize; i++){
+    for (size_t i = 0; i < dbSize; i++){
         if (dbSeqLens[i] > (k - 1))
             this->seqLens[i] = (float) (dbSeqLens[i] - k + 1);
         else
@@ -37,29 +45,44 @@ QueryScore::QueryScore (int dbSize, unsigned short * dbSeqLens, int k, short kme
     }
 
     this->seqLenSum = 0.0f;
-    for (int i = 0; i < dbSize; i++)
+    for (size_t i = 0; i < dbSize; i++)
         this->seqLenSum += this->seqLens[i];
 
     // initialize the points where a score threshold should be recalculated
-    std::list<int> steps_list;
-    float seqLen = this->seqLens[0];
+    // the threshold of a step is calculated for the longest sequence in the step
+    // (the sequences are sorted by length, or by content within length bins of 90%, see Prefiltering::getCacheLocalOrder)
+    std::list<size_t> steps_list;
+    std::list<float> stepLens_list;
+    float seqLen = *std::max_element(this->seqLens, this->seqLens + 8);
+    float stepLen = seqLen;
     steps_list.push_back(0);
     // check the sequence length and decide if it changed enough to recalculate the score threshold here
     // minimum step length is 8 (one __m128 register)
-    for (int i = 0; i < scores_128_size; i += 8){
-        if (this->seqLens[i]/seqLen < 0.9){
+    for (size_t i = 0; i < scores_128_size; i += 8){
+        float blockLen = *std::max_element(this->seqLens + i, this->seqLens + i + 8);
+        if (blockLen/seqLen < 0.9){
             steps_list.push_back(i);
-            seqLen = this->seqLens[i];
+            stepLens_list.push_back(stepLen);
+            seqLen = blockLen;
+            stepLen = blockLen;
         }
+        else
+            stepLen = std::max(stepLen, blockLen);
     }
     steps_list.push_back(scores_128_size);
+    stepLens_list.push_back(stepLen);
 
     nsteps = steps_list.size();
-    steps = new int[nsteps];
+    steps = new size_t[nsteps];
     for (int i = 0; i < nsteps; i++){
         steps[i] = steps_list.front();
         steps_list.pop_front();
     }
+    stepLens = new float[nsteps - 1];
+    for (int i = 0; i < nsteps - 1; i++){
+        stepLens[i] = stepLens_list.front();
+        stepLens_list.pop_front();
+    }
 
     this->resList = (hit_t *) Util::mem_align(16, MAX_RES_LIST_LEN * sizeof(hit_t) );
 
@@ -72,18 +95,70 @@ QueryScore::QueryScore (int dbSize, unsigned short * dbSeqLens, int k, short kme
     s_per_match = 0.0f;
 
     s_per_pos = 0.0f;
+
+    simdLevel = getSupportedSimdLevel();
+
+    stepThresholds = new unsigned short[nsteps - 1];
+    memset(stepThresholds, 0, (nsteps - 1) * sizeof(unsigned short));
+
+    sparseReset = false;
+    touchedBitmapSize = (scores_128_size / 8 + 31) / 32;
+    touchedBitmap = new unsigned int[touchedBitmapSize];
+    memset(touchedBitmap, 0, touchedBitmapSize * sizeof(unsigned int));
+    maxTouchedBlocks = scores_128_size / 8 / SPARSE_MAX_FRACTION;
+    touchedBlocks = new unsigned int[maxTouchedBlocks + 1];
+    touchedBlocksNum = 0;
 }
 
 QueryScore::~QueryScore (){
     free(scores_128);
-    free(thresholds_128);
     delete[] seqLens;
     delete[] steps;
+    delete[] stepLens;
+    delete[] stepThresholds;
+    delete[] touchedBitmap;
+    delete[] touchedBlocks;
     free(resList);
 }
 
-bool QueryScore::compareHits(hit_t first, hit_t second){
-    return (first.zScore > second.zScore) ? true : false;
+void QueryScore::resetScores(){
+    if (isSparse() && scores8 != NULL){
+        // a block of 8 scores is 8 byte
+        for (size_t i = 0; i < touchedBlocksNum; i++){
+            const unsigned int block = touchedBlocks[i];
+            _mm_storel_epi64((__m128i*) (scores8 + (size_t) block * 8), _mm_setzero_si128());
+            touchedBitmap[block >> 5] = 0;
+        }
+    }
+    else if (isSparse()){
+        const __m128i zero = _mm_setzero_si128();
+        for (size_t i = 0; i < touchedBlocksNum; i++){
+            const unsigned int block = touchedBlocks[i];
+            scores_128[block] = zero;
+            touchedBitmap[block >> 5] = 0;
+        }
+    }
+    else {
+        memset(scores_128, 0, scores_128_size * ((scores8 != NULL) ? 1 : 2));
+        memset(touchedBitmap, 0, touchedBitmapSize * sizeof(unsigned int));
+    }
+    touchedBlocksNum = 0;
+}
+
+int QueryScore::getSupportedSimdLevel(){
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        return SIMD_AVX512;
+    if (__builtin_cpu_supports("avx2"))
+        return SIMD_AVX2;
+    return SIMD_SSE2;
+}
+
+bool QueryScore::compareHits(const hit_t& first, const hit_t& second){
+    // equal z-scores are ordered by the sequence id, the first maxHits hits do not depend on the sorting algorithm
+    if (first.zScore != second.zScore)
+        return first.zScore > second.zScore;
+    return first.seqId < second.seqId;
 }
 
 void QueryScore::setPrefilteringThresholds(){
@@ -97,7 +172,8 @@ void QueryScore::setPrefilteringThresholds(){
     float numMatches_pc = seqLenSum_pc *  kmerMatchProb + 0.000001f;
    
     // pseudo-sum of k-mer scores
-    float matchScoresSum_pc = numMatches_pc * (float) (kmerThr + 8);
+    // (in the units of the k-mer match scores of the 16-bit scores, coarser quantization of the 8-bit scores)
+    float matchScoresSum_pc = numMatches_pc * (float) (kmerThr + 8) / (float) (1 << (kmerScoreShift - KMER_SCORE_SHIFT));
     this->s_per_match = ((float)scoresSum + matchScoresSum_pc)/((float)numMatches + numMatches_pc) + 0.000001f;
 
     float scoresSum_pc = seqLenSum_pc * kmerMatchProb * s_per_match;
@@ -110,87 +186,212 @@ void QueryScore::setPrefilteringThresholds(){
     unsigned short threshold_ushrt;
     unsigned int ushrt_max = USHRT_MAX;
 
-    __m128i* thr = thresholds_128;
-    __m128i v = _mm_setzero_si128();
-
     for (int i = 0; i < nsteps - 1; i++){
-        seqLen = seqLens[steps[i]];
+        seqLen = stepLens[i];
         mean = s_per_pos * seqLen;
         stddev = sqrt(seqLen * s_per_pos * s_per_match);
         threshold = zscore_thr * stddev + mean;
 
         // saturated conversion of float threshold into short threshold
         threshold_ushrt = (unsigned short) std::min(ushrt_max, (unsigned int) threshold);
+        // a saturated 8-bit score (255) is always above the threshold, a score of at least 255 is not lost
+        if (scores8 != NULL)
+            threshold_ushrt = std::min(threshold_ushrt, (unsigned short) (UCHAR_MAX - 1));
 
-        // store short treshold in a vector
-        v =  _mm_set1_epi16(threshold_ushrt);
+        // the threshold is valid for all sequences until the next step
+        stepThresholds[i] = threshold_ushrt;
+    }
+}
+
+float QueryScore::getZscore(size_t seqId){
+    return ( (float)getScore(seqId) - s_per_pos * seqLens[seqId] ) / sqrt(s_per_pos * seqLens[seqId] * s_per_match);
+}
 
-        // set all thresolds to the current value until calculation of the next value is necessary
-        for (int j = steps[i]; j < steps[i+1]; j += 8){
-            *thr = v;
-            thr++;
+size_t QueryScore::scanScores(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter){
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i thr = _mm_set1_epi16(threshold);
+    for (size_t pos = from; pos < to; pos += 8){
+        // look for entries above the threshold
+        __m128i cmp = _mm_subs_epu16(_mm_load_si128((__m128i*) (scores + pos)), thr);
+        cmp = _mm_cmpeq_epi16(cmp, zero);
+        // two set bits for each sequence above the threshold, the lower one is used
+        const unsigned int bits = ~_mm_movemask_epi8(cmp) & 0x5555;
+        if (bits != 0){
+            elementCounter = addHits(pos, bits, 1, identityId, elementCounter);
+            if (elementCounter >= MAX_RES_LIST_LEN)
+                return elementCounter;
         }
     }
+    return elementCounter;
 }
 
-float QueryScore::getZscore(int seqId){
-    return ( (float)scores[seqId] - s_per_pos * seqLens[seqId] ) / sqrt(s_per_pos * seqLens[seqId] * s_per_match);
+__attribute__((target("avx2,bmi")))
+size_t QueryScore::scanScoresAVX2(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter){
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i thr = _mm256_set1_epi16(threshold);
+    size_t pos = from;
+    for (; pos + 16 <= to; pos += 16){
+        __m256i cmp = _mm256_subs_epu16(_mm256_loadu_si256((__m256i*) (scores + pos)), thr);
+        cmp = _mm256_cmpeq_epi16(cmp, zero);
+        const unsigned int bits = ~((unsigned int) _mm256_movemask_epi8(cmp)) & 0x55555555;
+        if (bits != 0){
+            elementCounter = addHits(pos, bits, 1, identityId, elementCounter);
+            if (elementCounter >= MAX_RES_LIST_LEN)
+                return elementCounter;
+        }
+    }
+    // the rest of less than 16 sequences
+    return scanScores(pos, to, threshold, identityId, elementCounter);
 }
 
-std::pair<hit_t *, size_t> QueryScore::getResult (int querySeqLen, unsigned int identityId){
-    size_t elementCounter = 0;
-    const __m128i zero = _mm_setzero_si128(); 
+__attribute__((target("avx512f,avx512bw,bmi")))
+size_t QueryScore::scanScoresAVX512(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter){
+    const __m512i thr = _mm512_set1_epi16(threshold);
+    size_t pos = from;
+    for (; pos + 32 <= to; pos += 32){
+        // one bit for each sequence above the threshold
+        const unsigned int bits = _mm512_cmpgt_epu16_mask(_mm512_loadu_si512((void*) (scores + pos)), thr);
+        if (bits != 0){
+            elementCounter = addHits(pos, bits, 0, identityId, elementCounter);
+            if (elementCounter >= MAX_RES_LIST_LEN)
+                return elementCounter;
+        }
+    }
+    // the rest of less than 32 sequences
+    return scanScores(pos, to, threshold, identityId, elementCounter);
+}
 
-    __m128i* p = scores_128;
-    __m128i* thr = thresholds_128;
+size_t QueryScore::scanScores8(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter){
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i thr = _mm_set1_epi8((char) threshold);
+    // the steps are multiples of 8, 8 scores are loaded at once
+    for (size_t pos = from; pos < to; pos += 8){
+        __m128i cmp = _mm_subs_epu8(_mm_loadl_epi64((__m128i*) (scores8 + pos)), thr);
+        cmp = _mm_cmpeq_epi8(cmp, zero);
+        const unsigned int bits = ~_mm_movemask_epi8(cmp) & 0xFF;
+        if (bits != 0){
+            elementCounter = addHits(pos, bits, 0, identityId, elementCounter);
+            if (elementCounter >= MAX_RES_LIST_LEN)
+                return elementCounter;
+        }
+    }
+    return elementCounter;
+}
+
+__attribute__((target("avx2,bmi")))
+size_t QueryScore::scanScores8AVX2(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter){
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i thr = _mm256_set1_epi8((char) threshold);
+    size_t pos = from;
+    for (; pos + 32 <= to; pos += 32){
+        __m256i cmp = _mm256_subs_epu8(_mm256_loadu_si256((__m256i*) (scores8 + pos)), thr);
+        cmp = _mm256_cmpeq_epi8(cmp, zero);
+        const unsigned int bits = ~((unsigned int) _mm256_movemask_epi8(cmp));
+        if (bits != 0){
+            elementCounter = addHits(pos, bits, 0, identityId, elementCounter);
+            if (elementCounter >= MAX_RES_LIST_LEN)
+                return elementCounter;
+        }
+    }
+    // the rest of less than 32 sequences
+    return scanScores8(pos, to, threshold, identityId, elementCounter);
+}
+
+__attribute__((target("avx512f,avx512bw,bmi")))
+size_t QueryScore::scanScores8AVX512(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter){
+    const __m512i thr = _mm512_set1_epi8((char) threshold);
+    size_t pos = from;
+    for (; pos + 64 <= to; pos += 64){
+        // one bit for each of the 64 sequences, added in two halves
+        const unsigned long long bits = _mm512_cmpgt_epu8_mask(_mm512_loadu_si512((void*) (scores8 + pos)), thr);
+        if (bits != 0){
+            elementCounter = addHits(pos, (unsigned int) bits, 0, identityId, elementCounter);
+            elementCounter = addHits(pos + 32, (unsigned int) (bits >> 32), 0, identityId, elementCounter);
+            if (elementCounter >= MAX_RES_LIST_LEN)
+                return elementCounter;
+        }
+    }
+    // the rest of less than 64 sequences
+    return scanScores8(pos, to, threshold, identityId, elementCounter);
+}
+
+size_t QueryScore::scanTouchedBlocks(unsigned int identityId, size_t elementCounter){
+    // the hits are collected in the order of the sequence ids as in the full scan
+    std::sort(touchedBlocks, touchedBlocks + touchedBlocksNum);
+    const __m128i zero = _mm_setzero_si128();
+    int step = 0;
+    for (size_t i = 0; i < touchedBlocksNum; i++){
+        const size_t pos = (size_t) touchedBlocks[i] * 8;
+        while (steps[step + 1] <= pos)
+            step++;
+        unsigned int bits;
+        if (scores8 != NULL){
+            __m128i cmp = _mm_subs_epu8(_mm_loadl_epi64((__m128i*) (scores8 + pos)), _mm_set1_epi8((char) stepThresholds[step]));
+            cmp = _mm_cmpeq_epi8(cmp, zero);
+            bits = ~_mm_movemask_epi8(cmp) & 0xFF;
+        }
+        else {
+            __m128i cmp = _mm_subs_epu16(scores_128[touchedBlocks[i]], _mm_set1_epi16(stepThresholds[step]));
+            cmp = _mm_cmpeq_epi16(cmp, zero);
+            bits = ~_mm_movemask_epi8(cmp) & 0x5555;
+        }
+        if (bits != 0){
+            elementCounter = addHits(pos, bits, (scores8 != NULL) ? 0 : 1, identityId, elementCounter);
+            if (elementCounter >= MAX_RES_LIST_LEN)
+                return elementCounter;
+        }
+    }
+    return elementCounter;
+}
+
+std::pair<hit_t *, size_t> QueryScore::getResult (int querySeqLen, unsigned int identityId, size_t maxHits){
+    size_t elementCounter = 0;
 
-    __m128i cmp;
-    
     // check if there is the identity of the query sequence in the database
     // the identity should be included in the results
     if (identityId != UINT_MAX){
         elementCounter++;
     }
 
-    // go through each vector
-    for (int pos = 0; pos < scores_128_size/8; pos++ ){
-
-        // look for entries above the threshold
-        cmp = _mm_subs_epu16(*p, *thr);
-        cmp = _mm_cmpeq_epi16(cmp, zero);
-        const unsigned int cmp_set_bits = _mm_movemask_epi8(cmp);
-        
-        // here are some sequences above the prefiltering threshold
-        if (cmp_set_bits != 0xffff){
-            // and search for highest
-            for(int i = 0; i < 8; i++){
-                if(!CHECK_BIT(cmp_set_bits,i*2) && (pos * 8 + i) != identityId){
-                    const float zscore = getZscore(pos*8+i);
-                    hit_t * result = (resList + elementCounter);
-                    result->seqId = pos * 8 + i;
-                    result->zScore = zscore;
-                    result->prefScore = scores[pos*8+i];
-                    elementCounter++;
-                    if(elementCounter >= MAX_RES_LIST_LEN)
-                        goto OuterLoop;
-                }
+    // go through the scores and collect the sequences above the threshold of their step
+    if (isSparse())
+        elementCounter = scanTouchedBlocks(identityId, elementCounter);
+    else {
+        for (int i = 0; i < nsteps - 1 && elementCounter < MAX_RES_LIST_LEN; i++){
+            if (scores8 != NULL){
+                if (simdLevel == SIMD_AVX512)
+                    elementCounter = scanScores8AVX512(steps[i], steps[i+1], stepThresholds[i], identityId, elementCounter);
+                else if (simdLevel == SIMD_AVX2)
+                    elementCounter = scanScores8AVX2(steps[i], steps[i+1], stepThresholds[i], identityId, elementCounter);
+                else
+                    elementCounter = scanScores8(steps[i], steps[i+1], stepThresholds[i], identityId, elementCounter);
             }
+            else if (simdLevel == SIMD_AVX512)
+                elementCounter = scanScoresAVX512(steps[i], steps[i+1], stepThresholds[i], identityId, elementCounter);
+            else if (simdLevel == SIMD_AVX2)
+                elementCounter = scanScoresAVX2(steps[i], steps[i+1], stepThresholds[i], identityId, elementCounter);
+            else
+                elementCounter = scanScores(steps[i], steps[i+1], stepThresholds[i], identityId, elementCounter);
         }
-        p++;
-        thr++;
     }
-OuterLoop:
+
     // include the identity in results if its there
+    size_t first = 0;
     if (identityId != UINT_MAX){
         const float zscore = getZscore(identityId);
         hit_t * result = (resList + 0);
         result->seqId = identityId;
         result->zScore = zscore;
-        result->prefScore = scores[identityId];
-        std::sort(resList + 1, resList + elementCounter, compareHits);
+        result->prefScore = getScore(identityId);
+        first = 1;
+    }
+    if (maxHits > first && maxHits < elementCounter){
+        // select the best hits in linear time and sort only these
+        std::nth_element(resList + first, resList + maxHits - 1, resList + elementCounter, compareHits);
+        std::sort(resList + first, resList + maxHits - 1, compareHits);
     }
     else
-        std::sort(resList, resList + elementCounter, compareHits);
+        std::sort(resList + first, resList + elementCounter, compareHits);
 
     return std::make_pair<hit_t *, size_t>(resList, elementCounter);
 }
@@ -220,6 +421,6 @@ void QueryScore::printVector(__m128i v){
 
 void QueryScore::printScores(){
     std::cout << "Scores:\n";
-    for (int i = 0; i < dbSize; i++)
-        std::cout << scores[i] << "\n";
+    for (size_t i = 0; i < dbSize; i++)
+        std::cout << getScore(i) << "\n";
 }
@@ -36,32 +36,110 @@ typedef struct {
 class QueryScore {
     public:
 
-        QueryScore (int dbSize, unsigned short * seqLens, int k, short kmerThr, float kmerMatchProb, float zscoreThr);
+        // byteScores: 8-bit saturated scores instead of 16-bit scores (see QueryScoreGlobal8)
+        QueryScore (size_t dbSize, unsigned short * seqLens, int k, short kmerThr, float kmerMatchProb, float zscoreThr, bool byteScores = false);
 
         virtual ~QueryScore ();
 
         // add k-mer match score for all DB sequences from the list
-        virtual void addScores (int* seqList, int seqListSize, unsigned short score) = 0;
+        // queryPos: position of the k-mer in the query sequence, only used by the local score (QueryScoreSemiLocal)
+        virtual void addScores (unsigned int* seqList, size_t seqListSize, unsigned short score, unsigned short queryPos = 0) = 0;
 
         void setPrefilteringThresholds();
 
         void setPrefilteringThresholdsRevSeq();
 
-        float getZscore(int seqPos);
+        float getZscore(size_t seqPos);
 
        // get the list of the sequences with the score > z-score threshold 
-        std::pair<hit_t *, size_t> getResult (int querySeqLen, unsigned int identityId);
+        // maxHits > 0: only the first maxHits hits are sorted by z-score (the best ones), the rest is unsorted
+        std::pair<hit_t *, size_t> getResult (int querySeqLen, unsigned int identityId, size_t maxHits = 0);
 
         // reset the prefiltering score counter for the next query sequence
         virtual void reset () = 0;
 
+        // finish the score calculation of a query sequence, has to be called before the scores are read
+        // for implementations that do not add the scores directly
+        virtual void flushScores () {}
+
         void printScores();
 
         // maximal resultList
         static const size_t MAX_RES_LIST_LEN = 150000;
 
+        // instruction sets for the score scan in getResult
+        static const int SIMD_SSE2 = 0;
+        static const int SIMD_AVX2 = 1;
+        static const int SIMD_AVX512 = 2;
+
+        // the best instruction set supported by the CPU (CPUID)
+        static int getSupportedSimdLevel();
+
+        // use a lower instruction set than the one supported by the CPU (e.g. for testing)
+        void setSimdLevel(int level) { simdLevel = std::min(level, getSupportedSimdLevel()); }
+
+        int getSimdLevel() { return simdLevel; }
+
+        // track the blocks of 8 scores updated by addScores so that reset and getResult only visit these blocks
+        // (as long as at most 1/SPARSE_MAX_FRACTION of the blocks are touched, otherwise the whole score array is used)
+        // only supported by QueryScoreGlobal and QueryScorePartitioned (on by default), has to be called directly after reset
+        void setSparseReset(bool sparseReset) { this->sparseReset = sparseReset; }
+
+        static const size_t SPARSE_MAX_FRACTION = 16;
+
+        // the k-mer match scores are divided by 2^shift before they are added to the scores (QueryTemplateMatcher::match)
+        int getKmerScoreShift() { return kmerScoreShift; }
+
+        static const int KMER_SCORE_SHIFT = 2;
+
+        // coarser quantization for the 8-bit scores, a k-mer match adds about 8 to the score
+        static const int KMER_SCORE_SHIFT_8BIT = 4;
+
     private:
-        static bool compareHits(hit_t first, hit_t second);
+        static bool compareHits(const hit_t& first, const hit_t& second);
+
+        // append the sequences [from, to) (multiples of 8) with a score above the threshold to the result list
+        // returns the new number of results, stops at MAX_RES_LIST_LEN
+        size_t scanScores(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter);
+
+        size_t scanScoresAVX2(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter);
+
+        size_t scanScoresAVX512(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter);
+
+        // the same for the 8-bit scores
+        size_t scanScores8(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter);
+
+        size_t scanScores8AVX2(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter);
+
+        size_t scanScores8AVX512(size_t from, size_t to, unsigned short threshold, unsigned int identityId, size_t elementCounter);
+
+        // scans only the touched blocks in sparse mode
+        size_t scanTouchedBlocks(unsigned int identityId, size_t elementCounter);
+
+        // appends the sequences pos + (i >> bitShift) for the set bits i of the comparison mask (except the identity)
+        inline size_t addHits(size_t pos, unsigned int bits, int bitShift, unsigned int identityId, size_t elementCounter){
+            while (bits != 0 && elementCounter < MAX_RES_LIST_LEN){
+                const size_t seqId = pos + (__builtin_ctz(bits) >> bitShift);
+                bits &= bits - 1;
+                if (seqId != identityId){
+                    addHit(seqId, elementCounter);
+                    elementCounter++;
+                }
+            }
+            return elementCounter;
+        }
+
+        inline void addHit(size_t seqId, size_t elementCounter){
+            hit_t * result = (resList + elementCounter);
+            result->seqId = seqId;
+            result->zScore = getZscore(seqId);
+            result->prefScore = getScore(seqId);
+        }
+
+        int simdLevel;
+
+        // score threshold of each step, the same for all sequences in the step
+        unsigned short* stepThresholds;
 
         short sse2_extract_epi16(__m128i v, int pos);
 
@@ -79,6 +157,8 @@ class QueryScore {
 
         float zscore_thr;
 
+        int kmerScoreShift;
+
 
     protected:
         inline unsigned short sadd16(unsigned short a, unsigned short b)
@@ -87,6 +167,42 @@ class QueryScore {
             return -(s>>16) | (unsigned short)s;
         }
 
+        // mark the block of the sequence as touched
+        inline void touch(size_t seqId){
+            const size_t block = seqId >> 3;
+            const unsigned int bit = 1U << (block & 31);
+            if ((touchedBitmap[block >> 5] & bit) == 0){
+                touchedBitmap[block >> 5] |= bit;
+                if (touchedBlocksNum < maxTouchedBlocks)
+                    touchedBlocks[touchedBlocksNum] = block;
+                touchedBlocksNum++;
+            }
+        }
+
+        // the list of touched blocks is complete
+        bool isSparse() { return sparseReset && touchedBlocksNum <= maxTouchedBlocks; }
+
+        // set the scores to zero, only the touched blocks in sparse mode
+        void resetScores();
+
+        // sparse mode: one bit for each block of 8 scores in touchedBitmap and the ids of the first maxTouchedBlocks touched blocks
+        bool sparseReset;
+        unsigned int* touchedBitmap;
+        size_t touchedBitmapSize;
+        unsigned int* touchedBlocks;
+        size_t touchedBlocksNum;
+        size_t maxTouchedBlocks;
+
+        inline unsigned char sadd8(unsigned char a, unsigned char b)
+        {
+            unsigned int s = (unsigned int)(a+b);
+            return -(s>>8) | (unsigned char)s;
+        }
+
+        inline unsigned short getScore(size_t seqId){
+            return (scores8 != NULL) ? scores8[seqId] : scores[seqId];
+        }
+
         inline short sadd16_signed(short x, short y)
         {   
             unsigned short ux = x;
@@ -123,30 +239,31 @@ class QueryScore {
         }
 
         // size of the database in scores_128 vector (the rest of the last _m128i vector is filled with zeros)
-        int scores_128_size;
+        size_t scores_128_size;
         // position in the array: sequence id
         // entry in the array: prefiltering score
         __m128i* scores_128;
         unsigned short  * scores;
-
-        __m128i* thresholds_128;
-        unsigned short  * thresholds;
+        // 8-bit scores (byteScores), scores is NULL then
+        unsigned char * scores8;
 
         // float because it is needed for statistical calculations
         float * seqLens;
         float seqLenSum;
 
-        int* steps;
+        size_t* steps;
         int nsteps;
+        // length of the longest sequence in each step
+        float* stepLens;
 
         size_t scoresSum;
 
-        int numMatches;
+        size_t numMatches;
 
         float matches_per_pos;
 
         // number of sequences in the target DB
-        int dbSize;
+        size_t dbSize;
 
         // list of all DB sequences with the prefiltering score > z-score threshold with the corresponding scores
         hit_t * resList;
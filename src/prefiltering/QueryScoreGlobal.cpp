@@ -1,16 +1,24 @@
 #include "QueryScoreGlobal.h"
 
-void QueryScoreGlobal::addScores (int* seqList, int seqListSize, unsigned short score){
-    for (int i = 0; i < seqListSize; i++){
-        scores[seqList[i]] = sadd16(scores[seqList[i]], score);
+void QueryScoreGlobal::addScores (unsigned int* seqList, size_t seqListSize, unsigned short score, unsigned short queryPos){
+    // the touched blocks are only tracked until there are too many for the sparse mode
+    if (isSparse()){
+        for (size_t i = 0; i < seqListSize; i++){
+            scores[seqList[i]] = sadd16(scores[seqList[i]], score);
+            touch(seqList[i]);
+        }
+    }
+    else {
+        for (size_t i = 0; i < seqListSize; i++){
+            scores[seqList[i]] = sadd16(scores[seqList[i]], score);
+        }
     }
     scoresSum += score * seqListSize;
     numMatches += seqListSize;
 }
 
 void QueryScoreGlobal::reset() {
-    memset (scores_128, 0, scores_128_size * 2);
-    memset (thresholds_128, 0, scores_128_size * 2);
+    resetScores();
     scoresSum = 0;
     numMatches = 0;
 }
@@ -14,13 +14,14 @@
 class QueryScoreGlobal : public QueryScore {
 
     public:
-        QueryScoreGlobal(int dbSize, unsigned short * seqLens, int k, short kmerThr, double kmerMatchProb, float zscoreThr)
+        QueryScoreGlobal(size_t dbSize, unsigned short * seqLens, int k, short kmerThr, double kmerMatchProb, float zscoreThr)
             : QueryScore(dbSize, seqLens, k, kmerThr, kmerMatchProb, zscoreThr)    // Call the QueryScore constructor 
         {
+            this->sparseReset = true;
         };
 
 
-            void addScores (int* seqList, int seqListSize, unsigned short score);
+            void addScores (unsigned int* seqList, size_t seqListSize, unsigned short score, unsigned short queryPos = 0);
             void reset();
 
 
@@ -0,0 +1,25 @@
+#include "QueryScoreGlobal8.h"
+
+void QueryScoreGlobal8::addScores (unsigned int* seqList, size_t seqListSize, unsigned short score, unsigned short queryPos){
+    const unsigned char score8 = (unsigned char) std::min(score, (unsigned short) UCHAR_MAX);
+    // the touched blocks are only tracked until there are too many for the sparse mode
+    if (isSparse()){
+        for (size_t i = 0; i < seqListSize; i++){
+            scores8[seqList[i]] = sadd8(scores8[seqList[i]], score8);
+            touch(seqList[i]);
+        }
+    }
+    else {
+        for (size_t i = 0; i < seqListSize; i++){
+            scores8[seqList[i]] = sadd8(scores8[seqList[i]], score8);
+        }
+    }
+    scoresSum += score * seqListSize;
+    numMatches += seqListSize;
+}
+
+void QueryScoreGlobal8::reset() {
+    resetScores();
+    scoresSum = 0;
+    numMatches = 0;
+}
@@ -0,0 +1,27 @@
+#ifndef QUERYSCOREGLOBAL8_H
+#define QUERYSCOREGLOBAL8_H
+
+//
+// Global prefiltering score with 8-bit saturated score counters.
+// The score array needs half of the memory of QueryScoreGlobal, so twice as many target sequences fit into the cache.
+// The k-mer match scores are quantized coarser (KMER_SCORE_SHIFT_8BIT), the scores saturate at 255:
+// meant for high sequence identity runs, the z-scores of hits with a saturated score are lower bounds.
+//
+
+#include "QueryScore.h"
+
+class QueryScoreGlobal8 : public QueryScore {
+
+    public:
+        QueryScoreGlobal8(size_t dbSize, unsigned short * seqLens, int k, short kmerThr, double kmerMatchProb, float zscoreThr)
+            : QueryScore(dbSize, seqLens, k, kmerThr, kmerMatchProb, zscoreThr, true)
+        {
+            this->sparseReset = true;
+        };
+
+        void addScores (unsigned int* seqList, size_t seqListSize, unsigned short score, unsigned short queryPos = 0);
+
+        void reset();
+};
+
+#endif
@@ -0,0 +1,64 @@
+#include "QueryScorePartitioned.h"
+
+QueryScorePartitioned::QueryScorePartitioned(size_t dbSize, unsigned short * seqLens, int k, short kmerThr, double kmerMatchProb, float zscoreThr)
+    : QueryScore(dbSize, seqLens, k, kmerThr, kmerMatchProb, zscoreThr)
+{
+    this->partitions = (dbSize + PARTITION_SIZE - 1) / PARTITION_SIZE;
+    this->buffers = new unsigned int[partitions * PARTITION_BUFFER_SIZE];
+    this->bufferSizes = new size_t[partitions];
+    memset(bufferSizes, 0, sizeof(size_t) * partitions);
+    this->sparseReset = true;
+}
+
+QueryScorePartitioned::~QueryScorePartitioned(){
+    delete[] buffers;
+    delete[] bufferSizes;
+}
+
+void QueryScorePartitioned::addScores (unsigned int* seqList, size_t seqListSize, unsigned short score, unsigned short queryPos){
+    for (size_t i = 0; i < seqListSize; i++){
+        const unsigned int seqId = seqList[i];
+        const size_t partition = seqId >> PARTITION_BITS;
+        size_t bufferSize = bufferSizes[partition];
+        buffers[partition * PARTITION_BUFFER_SIZE + bufferSize] = (seqId << PARTITION_BITS) | score;
+        bufferSize++;
+        if (bufferSize == PARTITION_BUFFER_SIZE){
+            bufferSizes[partition] = bufferSize;
+            flushPartition(partition);
+            bufferSize = 0;
+        }
+        bufferSizes[partition] = bufferSize;
+    }
+    scoresSum += score * seqListSize;
+    numMatches += seqListSize;
+}
+
+void QueryScorePartitioned::flushPartition(size_t partition){
+    unsigned short* partitionScores = scores + partition * PARTITION_SIZE;
+    const unsigned int* buffer = buffers + partition * PARTITION_BUFFER_SIZE;
+    const size_t bufferSize = bufferSizes[partition];
+    const size_t partitionStart = partition * PARTITION_SIZE;
+    const bool track = isSparse();
+    for (size_t i = 0; i < bufferSize; i++){
+        const unsigned int hit = buffer[i];
+        const unsigned int pos = hit >> PARTITION_BITS;
+        partitionScores[pos] = sadd16(partitionScores[pos], (unsigned short) hit);
+        if (track)
+            touch(partitionStart + pos);
+    }
+    bufferSizes[partition] = 0;
+}
+
+void QueryScorePartitioned::flushScores(){
+    for (size_t p = 0; p < partitions; p++){
+        if (bufferSizes[p] > 0)
+            flushPartition(p);
+    }
+}
+
+void QueryScorePartitioned::reset() {
+    resetScores();
+    memset (bufferSizes, 0, sizeof(size_t) * partitions);
+    scoresSum = 0;
+    numMatches = 0;
+}
@@ -0,0 +1,51 @@
+#ifndef QUERYSCOREPARTITIONED_H
+#define QUERYSCOREPARTITIONED_H
+
+//
+// Global prefiltering score with cache-blocked accumulation for large target databases.
+// The k-mer hits are not added to the score array directly but buffered in radix partitions of PARTITION_SIZE sequences
+// (the upper bits of the sequence id). A full partition buffer is added to its part of the score array at once,
+// so the random accesses of the score updates stay within a block of the score array that fits into the L2 cache.
+// The saturated addition of the non-negative scores does not depend on the order, the results are the same as with QueryScoreGlobal.
+// With few hits per partition the buffers are flushed mostly at the end of the query, then the direct updates are faster
+// (selected with mmseqs_pref --partitioned-scores).
+//
+
+#include "QueryScore.h"
+
+class QueryScorePartitioned : public QueryScore {
+
+    public:
+        QueryScorePartitioned(size_t dbSize, unsigned short * seqLens, int k, short kmerThr, double kmerMatchProb, float zscoreThr);
+
+        ~QueryScorePartitioned();
+
+        void addScores (unsigned int* seqList, size_t seqListSize, unsigned short score, unsigned short queryPos = 0);
+
+        // adds the hits remaining in the partition buffers to the scores
+        void flushScores();
+
+        void reset();
+
+        // a buffered hit stores the sequence id within the partition in the upper and the score in the lower 16 bits
+        static const int PARTITION_BITS = 16;
+
+        // 2^16 sequences, 128 KB of scores
+        static const size_t PARTITION_SIZE = (1 << PARTITION_BITS);
+
+        // number of hits buffered per partition
+        static const size_t PARTITION_BUFFER_SIZE = 16384;
+
+    private:
+        void flushPartition(size_t partition);
+
+        size_t partitions;
+
+        // partitions * PARTITION_BUFFER_SIZE buffered hits (64 KB per partition, about 1 byte per target sequence)
+        unsigned int* buffers;
+
+        // number of hits in each partition buffer
+        size_t* bufferSizes;
+};
+
+#endif
@@ -9,26 +9,36 @@
 #include "QueryScoreSemiLocal.h"
 
 QueryScoreSemiLocal::~QueryScoreSemiLocal(){
-    free(scores_128);
-    delete resList;
     delete[] lastScores;
 }
 
-void QueryScoreSemiLocal::addScores(int *seqList, int seqListSize, unsigned short score){
-    const int currentMatchPos=0;
-    const int f = 1;
-    for (int i = 0; i < seqListSize; i++){
-        const int seqId=seqList[i];
-        LastScore lastScore = this->lastScores[seqId];
-        short scoreDrop = f*(currentMatchPos - lastScore.lastMatchPos);
-        lastScore.lastScore          = std::max( 0,lastScore.lastScore - scoreDrop ); // saturated subtract
-        lastScore.lastScore          = sadd16_signed(lastScore.lastScore , score);
-        scores[seqId]                = std::max(scores[seqId],lastScore.lastScore);
-        lastScore.lastMatchPos       = currentMatchPos;
+void QueryScoreSemiLocal::addScores(unsigned int *seqList, size_t seqListSize, unsigned short score, unsigned short queryPos){
+    const bool track = isSparse();
+    for (size_t i = 0; i < seqListSize; i++){
+        const unsigned int seqId = seqList[i];
+        LastScore& lastScore = this->lastScores[seqId];
+        // saturated subtraction of the score drop since the last match
+        const unsigned int drop = (unsigned int) scoreDrop * (unsigned short) (queryPos - lastScore.lastMatchPos);
+        lastScore.lastScore    = (lastScore.lastScore > drop) ? (unsigned short) (lastScore.lastScore - drop) : 0;
+        lastScore.lastScore    = sadd16(lastScore.lastScore, score);
+        lastScore.lastMatchPos = queryPos;
+        scores[seqId]          = std::max(scores[seqId], lastScore.lastScore);
+        if (track)
+            touch(seqId);
     }
+    scoresSum += score * seqListSize;
+    numMatches += seqListSize;
 }
 
 void QueryScoreSemiLocal::reset() {
-    memset (scores_128, 0, scores_128_size * 2);
-    memset (this->lastScores, 0, sizeof(LastScore) * dbSize);    
+    // the running scores are reset for the same blocks of 8 sequences as the scores
+    if (isSparse()){
+        for (size_t i = 0; i < touchedBlocksNum; i++)
+            memset(lastScores + (size_t) touchedBlocks[i] * 8, 0, sizeof(LastScore) * 8);
+    }
+    else
+        memset (this->lastScores, 0, sizeof(LastScore) * dbSize);
+    resetScores();
+    scoresSum = 0;
+    numMatches = 0;
 }
@@ -8,31 +8,48 @@
 
 #ifndef QUERYSCORESEMILOCAL_H
 #define QUERYSCORESEMILOCAL_H
+
+//
+// Local prefiltering score: the score of a DB sequence is the best score of a local run of k-mer matches along the query.
+// The running score of a DB sequence drops by scoreDrop per query position since its last k-mer match (not below zero),
+// so k-mer matches scattered over the whole query (e.g. different domains of a multi-domain protein, or random matches)
+// add up less than a contiguous matching region.
+// The index table contains no positions in the DB sequences, the matches are ordered by the query position only.
+// The k-mer matches have to be added in the order of the query positions.
+//
+
 #include "QueryScore.h"
 
 class QueryScoreSemiLocal : public QueryScore {
     
 public:
-    QueryScoreSemiLocal(int dbSize, unsigned short * seqLens, int k, short kmerThr, double kmerMatchProb, float zscoreThr)
+    QueryScoreSemiLocal(size_t dbSize, unsigned short * seqLens, int k, short kmerThr, double kmerMatchProb, float zscoreThr, unsigned short scoreDrop = DEFAULT_SCORE_DROP)
     : QueryScore(dbSize, seqLens, k, kmerThr, kmerMatchProb, zscoreThr)    // Call the QueryScore constructor
     {
-        this->lastScores = new LastScore[dbSize];
-        memset (this->lastScores, 0, sizeof(LastScore) * dbSize);
+        this->scoreDrop = scoreDrop;
+        this->lastScores = new LastScore[scores_128_size];
+        memset (this->lastScores, 0, sizeof(LastScore) * scores_128_size);
+        this->sparseReset = true;
     };
 
     ~QueryScoreSemiLocal();
 
      struct LastScore{ 
          unsigned short lastScore;
-         short lastMatchPos;
+         unsigned short lastMatchPos;
      };
     
-    void addScores (int* seqList, int seqListSize, unsigned short score);
+    void addScores (unsigned int* seqList, size_t seqListSize, unsigned short score, unsigned short queryPos = 0);
 
     void reset();
 
+    // score drop per query position (in the units of the k-mer match scores, 1/2 bit)
+    static const unsigned short DEFAULT_SCORE_DROP = 1;
+
 private:
-    // last scores for local matching
+    // running local score and query position of the last k-mer match of each DB sequence
     LastScore * lastScores;
+
+    unsigned short scoreDrop;
 };
 #endif /* defined(QUERYSCORESEMILOCAL_H) */
@@ -1,5 +1,10 @@
 #include "QueryTemplateMatcher.h"
 #include "QueryScoreGlobal.h"
+#include "QueryScoreGlobal8.h"
+#include "QueryScoreSemiLocal.h"
+#include "QueryScorePartitioned.h"
+#include "../commons/Util.h"
+
 QueryTemplateMatcher::QueryTemplateMatcher ( BaseMatrix* m,
         ExtendedSubstitutionMatrix* _2merSubMatrix,
         ExtendedSubstitutionMatrix* _3merSubMatrix,
@@ -8,115 +13,284 @@ QueryTemplateMatcher::QueryTemplateMatcher ( BaseMatrix* m,
         short kmerThr,
         double kmerMatchProb,
         int kmerSize, 
-        int dbSize,
+        size_t dbSize,
         bool aaBiasCorrection,
         int maxSeqLen,
-        float zscoreThr){
+        float zscoreThr,
+        int batchSize,
+        bool byteScores,
+        bool localScore,
+        KmerListCache* kmerListCache,
+        bool partitionedScores){
     this->m = m;
     this->indexTable = indexTable;
     this->kmerSize = kmerSize;
+    // the k-mers of the query are extracted with the same (spaced) seed pattern as the k-mers in the index table
+    this->indexer = new Indexer(m->alphabetSize, kmerSize, indexTable->getSpacedSeed());
+    this->seedSpan = indexer->getSeedSpan();
+    this->spacedKmer = new int[kmerSize];
     this->kmerGenerator = new KmerGenerator(kmerSize, m->alphabetSize, kmerThr, _3merSubMatrix, _2merSubMatrix);
-    this->queryScore    = new QueryScoreGlobal(dbSize, seqLens, kmerSize, kmerThr, kmerMatchProb, zscoreThr);
+    this->kmerListCache = kmerListCache;
+    // a DB sequence of length L contains L - seedSpan + 1 k-mers
+    // the score array of large databases does not fit into the cache, the score updates can be partitioned
+    this->batchSize = batchSize;
+    if (localScore && batchSize > 1){
+        Debug(Debug::ERROR) << "The local prefiltering score can not be used with query batches.\n";
+        exit(EXIT_FAILURE);
+    }
+    this->batchScores = new QueryScore*[batchSize];
+    for (int i = 0; i < batchSize; i++){
+        if (localScore)
+            batchScores[i] = new QueryScoreSemiLocal(dbSize, seqLens, seedSpan, kmerThr, kmerMatchProb, zscoreThr);
+        else if (byteScores)
+            batchScores[i] = new QueryScoreGlobal8(dbSize, seqLens, seedSpan, kmerThr, kmerMatchProb, zscoreThr);
+        else if (partitionedScores)
+            batchScores[i] = new QueryScorePartitioned(dbSize, seqLens, seedSpan, kmerThr, kmerMatchProb, zscoreThr);
+        else
+            batchScores[i] = new QueryScoreGlobal(dbSize, seqLens, seedSpan, kmerThr, kmerMatchProb, zscoreThr);
+    }
+    this->queryScore = batchScores[0];
+    this->kmerScoreShift = queryScore->getKmerScoreShift();
+    this->batchQueries = 0;
+    this->batchMatched = false;
+    this->batchQueryLens = new int[batchSize];
+    this->batchIdentityIds = new unsigned int[batchSize];
+    this->batchStats = new statistics_t[batchSize];
+    this->batchResults = new std::pair<hit_t *, size_t>[batchSize];
+    this->batchQueryBits = 0;
+    while ((1 << batchQueryBits) < batchSize)
+        batchQueryBits++;
+    this->batchKmerBits = 0;
+    while (((size_t) 1 << batchKmerBits) < indexTable->tableSize)
+        batchKmerBits++;
     this->aaBiasCorrection = aaBiasCorrection;
+    this->localBiasCorrection = new LocalBiasCorrection(m);
 
     this->deltaS = new float[maxSeqLen];
     memset(this->deltaS, 0, maxSeqLen * sizeof(float));
+
+    this->seqListDecoder = new SequenceListCodec();
+    this->seqListBuffer = (unsigned int*) Util::mem_align(16, SequenceListCodec::BLOCK_SIZE * sizeof(unsigned int));
 }
 
 QueryTemplateMatcher::~QueryTemplateMatcher (){
     delete[] deltaS;
+    delete localBiasCorrection;
+    delete seqListDecoder;
+    free(seqListBuffer);
     delete kmerGenerator;
-    delete queryScore;
+    for (int i = 0; i < batchSize; i++)
+        delete batchScores[i];
+    delete[] batchScores;
+    delete[] batchQueryLens;
+    delete[] batchIdentityIds;
+    delete[] batchStats;
+    delete[] batchResults;
+    delete indexer;
+    delete[] spacedKmer;
 }
 
 void QueryTemplateMatcher::calcLocalAaBiasCorrection(Sequence* seq){
-    int windowSize = 40;
-    if (seq->L < windowSize + 1)
-        memset(this->deltaS, 0, seq->L * sizeof(float));
-    else{
-        float deltaS_i;
-        int minPos;
-        int maxPos;
-        int _2d;
-        // calculate local amino acid bias 
-        for (int i = 0; i < seq->L; i++){
-            deltaS_i = 0.0;
-            minPos = std::max(0, (i - windowSize/2));
-            maxPos = std::min(seq->L, (i + windowSize/2));
-            _2d = maxPos - minPos;
-
-            // negative score for the amino acids in the neighborhood of i
-            for (int j = minPos; j < maxPos; j++){
-                if (j != i){
-                    deltaS_i += m->subMatrix[seq->int_sequence[i]][seq->int_sequence[j]];
-                }
-            }
-            deltaS_i /= -1.0 * _2d;
-            // positive score for the background score distribution for i
-            for (int a = 0; a < m->alphabetSize; a++)
-                deltaS_i += m->pBack[a] * m->subMatrix[seq->int_sequence[i]][a];
-
-            deltaS[i] = deltaS_i;
-        }
-    }
+    localBiasCorrection->calc(seq->int_sequence, seq->L, deltaS);
 }
 
-std::pair<hit_t *, size_t> QueryTemplateMatcher::matchQuery (Sequence * seq, unsigned int identityId){
+std::pair<hit_t *, size_t> QueryTemplateMatcher::matchQuery (Sequence * seq, unsigned int identityId, size_t maxHits){
     queryScore->reset();
     seq->resetCurrPos();
 
     match(seq);
+    queryScore->flushScores();
 
     queryScore->setPrefilteringThresholds();
 
-    return queryScore->getResult(seq->L, identityId);
+    return queryScore->getResult(seq->L, identityId, maxHits);
+}
+
+void QueryTemplateMatcher::addBatchQuery(Sequence* seq, unsigned int identityId){
+    if (batchMatched){
+        batchKmers.clear();
+        batchQueries = 0;
+        batchMatched = false;
+    }
+    if (batchQueries == batchSize){
+        Debug(Debug::ERROR) << "Too many queries in the batch (batch size " << batchSize << ").\n";
+        exit(EXIT_FAILURE);
+    }
+    seq->resetCurrPos();
+    match(seq, batchQueries);
+    batchQueryLens[batchQueries] = seq->L;
+    batchIdentityIds[batchQueries] = identityId;
+    batchStats[batchQueries] = *seq->stats;
+    batchQueries++;
+}
+
+void QueryTemplateMatcher::sortBatchKmers(){
+    const size_t n = batchKmers.size();
+    if (n == 0)
+        return;
+    batchKmersTmp.resize(n);
+    unsigned long long* in = &batchKmers[0];
+    unsigned long long* out = &batchKmersTmp[0];
+    const unsigned long long digitMask = (1 << RADIX_BITS) - 1;
+    size_t counts[1 << RADIX_BITS];
+    // the score in the lower 16 bits does not need to be sorted
+    for (int shift = 16; shift < 16 + batchQueryBits + batchKmerBits; shift += RADIX_BITS){
+        memset(counts, 0, sizeof(counts));
+        for (size_t i = 0; i < n; i++)
+            counts[(in[i] >> shift) & digitMask]++;
+        size_t sum = 0;
+        for (size_t d = 0; d <= digitMask; d++){
+            size_t count = counts[d];
+            counts[d] = sum;
+            sum += count;
+        }
+        for (size_t i = 0; i < n; i++)
+            out[counts[(in[i] >> shift) & digitMask]++] = in[i];
+        std::swap(in, out);
+    }
+    if (in != &batchKmers[0])
+        batchKmers.swap(batchKmersTmp);
+}
+
+void QueryTemplateMatcher::matchBatch(size_t maxHits){
+    for (int i = 0; i < batchQueries; i++)
+        batchScores[i]->reset();
+    // queries sharing a k-mer are next to each other, the sequence lists are read in the order of the index table
+    sortBatchKmers();
+    const int kmerShift = 16 + batchQueryBits;
+    const unsigned long long queryMask = (1 << batchQueryBits) - 1;
+
+    bool compressedIndex = indexTable->isCompressed();
+    size_t start = 0;
+    while (start < batchKmers.size()){
+        const unsigned int kmer = batchKmers[start] >> kmerShift;
+        size_t end = start + 1;
+        while (end < batchKmers.size() && (batchKmers[end] >> kmerShift) == kmer)
+            end++;
+
+        size_t indexTabListSize = 0;
+        if (compressedIndex){
+            unsigned char* encodedList = indexTable->getCompressedDBSeqList(kmer, &indexTabListSize);
+            seqListDecoder->initDecoding(encodedList, indexTabListSize);
+            int blockSize;
+            while ((blockSize = seqListDecoder->decodeNextBlock(seqListBuffer)) > 0){
+                for (size_t j = start; j < end; j++)
+                    batchScores[(batchKmers[j] >> 16) & queryMask]->addScores(seqListBuffer, blockSize, (unsigned short) batchKmers[j]);
+            }
+        }
+        else {
+            unsigned int* seqList = indexTable->getDBSeqList(kmer, &indexTabListSize);
+            // the block of the list stays in the L1 cache while it is added to the scores of all queries
+            for (size_t pos = 0; pos < indexTabListSize; pos += BATCH_LIST_BLOCK_SIZE){
+                const size_t blockSize = std::min(BATCH_LIST_BLOCK_SIZE, indexTabListSize - pos);
+                for (size_t j = start; j < end; j++)
+                    batchScores[(batchKmers[j] >> 16) & queryMask]->addScores(seqList + pos, blockSize, (unsigned short) batchKmers[j]);
+            }
+        }
+        start = end;
+    }
+
+    for (int i = 0; i < batchQueries; i++){
+        batchScores[i]->flushScores();
+        batchScores[i]->setPrefilteringThresholds();
+        batchResults[i] = batchScores[i]->getResult(batchQueryLens[i], batchIdentityIds[i], maxHits);
+    }
+    batchMatched = true;
 }
 
-void QueryTemplateMatcher::match(Sequence* seq){
+void QueryTemplateMatcher::match(Sequence* seq, int batchIdx){
 
     seq->resetCurrPos();
     
     if (this->aaBiasCorrection)
         calcLocalAaBiasCorrection(seq);
 
-    int* seqList;
-    int indexTabListSize = 0;
+    unsigned int* seqList;
+    size_t indexTabListSize = 0;
     // go through the query sequence
     int kmerListLen = 0;
-    int numMatches = 0;
+    size_t numMatches = 0;
+    size_t cacheHits = 0;
+    size_t cacheMisses = 0;
+    bool compressedIndex = indexTable->isCompressed();
 
+    const bool spaced = indexer->isSpaced();
+    const int* seedPositions = indexer->getSeedPositions();
     float biasCorrection = 0;
     for (int i = 0; i < kmerSize && i < seq->L; i++)
         biasCorrection += deltaS[i];
 
     int pos = 0;
     short zero = 0;
-    while(seq->hasNextKmer(kmerSize)){
-        const int* kmer = seq->nextKmer(kmerSize);
-        // generate k-mer list
-        KmerGeneratorResult kmerList = kmerGenerator->generateKmerList(kmer);
+    while(seq->hasNextKmer(seedSpan)){
+        const int* kmer = seq->nextKmer(seedSpan);
+        if (spaced){
+            // the k-mer generator works on the k residues at the seed positions
+            indexer->getSpacedKmer(kmer, spacedKmer);
+            kmer = spacedKmer;
+            biasCorrection = 0;
+            for (int i = 0; i < kmerSize; i++)
+                biasCorrection += deltaS[pos + seedPositions[i]];
+        }
+        // generate k-mer list or take it from the cache
+        KmerGeneratorResult kmerList;
+        if (kmerListCache == NULL)
+            kmerList = kmerGenerator->generateKmerList(kmer);
+        else {
+            const unsigned int queryKmerIdx = indexer->int2index(kmer, 0, kmerSize);
+            if (kmerListCache->get(queryKmerIdx, &kmerList))
+                cacheHits++;
+            else {
+                kmerList = kmerGenerator->generateKmerList(kmer);
+                kmerListCache->add(queryKmerIdx, kmerList);
+                cacheMisses++;
+            }
+        }
         kmerListLen += kmerList.count;
-        std::pair<short,unsigned int> * retList = kmerList.scoreKmerList;
 
         // match the index table
         for (unsigned int i = 0; i < kmerList.count; i++){
-            std::pair<short,unsigned int> kmerMatch = retList[i];
-            short kmerMatchScore = kmerMatch.first + (short) biasCorrection;
+            const unsigned int kmerIdx = kmerList.index[i];
+            short kmerMatchScore = kmerList.score[i] + (short) biasCorrection;
             // avoid unsigned short overflow
             kmerMatchScore = std::max(kmerMatchScore, zero);
 
-            seqList = indexTable->getDBSeqList(kmerMatch.second, &indexTabListSize);
+            if (batchIdx >= 0){
+                // the sequence lists of most similar k-mers are empty, they are not sorted and matched in the batch
+                indexTabListSize = indexTable->getListSize(kmerIdx);
+                if (indexTabListSize == 0)
+                    continue;
+                numMatches += indexTabListSize;
+                batchKmers.push_back(((unsigned long long) kmerIdx << (16 + batchQueryBits))
+                        | ((unsigned long long) batchIdx << 16) | (unsigned short) (kmerMatchScore >> kmerScoreShift));
+                continue;
+            }
+
+            if (compressedIndex){
+                // decode the list block by block, the blocks stay in the L1 cache
+                unsigned char* encodedList = indexTable->getCompressedDBSeqList(kmerIdx, &indexTabListSize);
+                numMatches += indexTabListSize;
+                seqListDecoder->initDecoding(encodedList, indexTabListSize);
+                int blockSize;
+                while ((blockSize = seqListDecoder->decodeNextBlock(seqListBuffer)) > 0)
+                    queryScore->addScores(seqListBuffer, blockSize, (kmerMatchScore >> kmerScoreShift), pos);
+                continue;
+            }
+            seqList = indexTable->getDBSeqList(kmerIdx, &indexTabListSize);
             numMatches += indexTabListSize;
 
             // add the scores for the k-mer to the overall score for this query sequence
             // for the overall score, bit/2 is a sufficient sensitivity and we can use the capacity of unsigned short max score in QueryScore better
-            queryScore->addScores(seqList, indexTabListSize, (kmerMatchScore/4));
+            // (2 bit for the 8-bit scores)
+            queryScore->addScores(seqList, indexTabListSize, (kmerMatchScore >> kmerScoreShift), pos);
         }
         biasCorrection -= deltaS[pos];
         biasCorrection += deltaS[pos + kmerSize];
         pos++;
     }
     // write statistics
+    if (kmerListCache != NULL)
+        kmerListCache->addStatistics(cacheHits, cacheMisses);
     seq->stats->kmersPerPos = ((float)kmerListLen/(float)seq->L);
     seq->stats->dbMatches = numMatches;
 
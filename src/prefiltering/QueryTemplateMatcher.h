@@ -2,6 +2,7 @@
 #define QUERY_TEMPLATE_MATCHER_H
 
 #include <list>
+#include <vector>
 #include <iostream>
 #include <cstring>
 
@@ -12,11 +13,17 @@
 #include "QueryScore.h"
 #include "IndexTable.h"
 #include "KmerGenerator.h"
+#include "KmerListCache.h"
+#include "LocalBiasCorrection.h"
 #include "Indexer.h"
 
 
 class QueryTemplateMatcher {
     public:
+        // localScore: local score along the query (QueryScoreSemiLocal) instead of the sum of all k-mer match scores
+        // kmerListCache: similar k-mer lists shared by all matchers with the same k-mer threshold (NULL: no cache)
+        // partitionedScores: buffer the score updates in partitions of the target sequences (QueryScorePartitioned),
+        // faster for large target databases with many k-mer matches per target sequence, needs about dbSize byte more per query of the batch
         QueryTemplateMatcher (BaseMatrix* m,
                 ExtendedSubstitutionMatrix* _2merSubMatrix,
                 ExtendedSubstitutionMatrix* _3merSubMatrix,
@@ -25,34 +32,89 @@ class QueryTemplateMatcher {
                 short kmerThr,
                 double kmerMatchProb,
                 int kmerSize,
-                int dbSize,
+                size_t dbSize,
                 bool aaBiasCorrecion,
                 int maxSeqLen,
-                float zscoreThr); 
+                float zscoreThr,
+                int batchSize = 1,
+                bool byteScores = false,
+                bool localScore = false,
+                KmerListCache* kmerListCache = NULL,
+                bool partitionedScores = false);
 
         ~QueryTemplateMatcher();
         // returns result for the sequence
         // identityId is the id of the identitical sequence in the target database if there is any, UINT_MAX otherwise
-        std::pair<hit_t *, size_t>  matchQuery (Sequence * seq, unsigned int identityId);
+        // maxHits > 0: only the best maxHits results are sorted (see QueryScore::getResult)
+        std::pair<hit_t *, size_t>  matchQuery (Sequence * seq, unsigned int identityId, size_t maxHits = 0);
         // calculate local amino acid bias correction score for each position in the sequence
         void calcLocalAaBiasCorrection(Sequence* seq);
+
+        // batched matching of up to batchSize query sequences:
+        // addBatchQuery collects the similar k-mers of a query (the Sequence object can be reused for the next query),
+        // matchBatch sorts the k-mers of all queries and reads each sequence list of the index table once for the whole batch.
+        // The results stay valid until the next addBatchQuery call after matchBatch starts a new batch.
+        // Not supported with the local score (the query positions of the k-mers are not kept).
+        void addBatchQuery(Sequence* seq, unsigned int identityId);
+        void matchBatch(size_t maxHits = 0);
+        std::pair<hit_t *, size_t> getBatchResult(int i) { return batchResults[i]; }
+        statistics_t* getBatchStats(int i) { return &batchStats[i]; }
     private:
+        // sorts the collected k-mers of the batch by k-mer index and query (LSD radix sort over the key bits)
+        void sortBatchKmers();
+
+        // digit width of the radix sort in bits
+        static const int RADIX_BITS = 11;
+
+        // number of sequence list entries that are added to the scores of all queries of a batch at once (16 KB, fits into the L1 cache)
+        static const size_t BATCH_LIST_BLOCK_SIZE = 4096;
+
         // match sequence against the IndexTable
-        void match(Sequence* seq);
+        // batchIdx >= 0: collect the k-mers for the query batchIdx of the batch instead of adding the scores
+        void match(Sequence* seq, int batchIdx = -1);
         // scoring matrix for local amino acid bias correction
         BaseMatrix * m;
         /* generates kmer lists */
         KmerGenerator * kmerGenerator;
+        // cache of the k-mer lists, not owned by the matcher
+        KmerListCache * kmerListCache;
         /* contains the sequences for a kmer */
         IndexTable * indexTable;
         /* calculates the score */
         QueryScore * queryScore;
+        // the k-mer match scores are divided by 2^kmerScoreShift (depends on the score width of QueryScore)
+        int kmerScoreShift;
         // k of the k-mer
         int kmerSize;
+        // extracts the k-mers of spaced seeds from the query sequence
+        Indexer* indexer;
+        // length of the sequence window of one k-mer, equal to kmerSize for contiguous k-mers
+        int seedSpan;
+        int* spacedKmer;
         // local amino acid bias correction
         bool aaBiasCorrection;
+        LocalBiasCorrection* localBiasCorrection;
         // local score correction values
         float* deltaS;
+        // decoder and 16 byte aligned buffer for the sequence lists of compressed index tables
+        SequenceListCodec* seqListDecoder;
+        unsigned int* seqListBuffer;
+
+        // maximum number of queries per batch, one score object per query (batchScores[0] == queryScore)
+        int batchSize;
+        QueryScore** batchScores;
+        // number of queries in the current batch
+        int batchQueries;
+        bool batchMatched;
+        // k-mer match of a query in the batch: k-mer index << (queryBits + 16) | query << 16 | score
+        std::vector<unsigned long long> batchKmers;
+        std::vector<unsigned long long> batchKmersTmp;
+        int batchQueryBits;
+        int batchKmerBits;
+        int* batchQueryLens;
+        unsigned int* batchIdentityIds;
+        statistics_t* batchStats;
+        std::pair<hit_t *, size_t>* batchResults;
 
 };
 
@@ -0,0 +1,157 @@
+#include "SequenceListCodec.h"
+
+int SequenceListCodec::bitWidth(unsigned int maxVal){
+    int b = 0;
+    while (b < 32 && (maxVal >> b) != 0)
+        b++;
+    return b;
+}
+
+size_t SequenceListCodec::maxEncodedSize(size_t listSize){
+    size_t blocks = listSize / BLOCK_SIZE;
+    size_t rest = listSize % BLOCK_SIZE;
+    return blocks * (1 + BLOCK_SIZE * 4) + 1 + rest * 4;
+}
+
+size_t SequenceListCodec::encode(const unsigned int* seqList, size_t listSize, unsigned char* out){
+    unsigned char* start = out;
+    unsigned int deltas[BLOCK_SIZE];
+    unsigned int prev = 0;
+    size_t pos = 0;
+
+    // full blocks in the vertical layout
+    while (listSize - pos >= BLOCK_SIZE){
+        unsigned int maxDelta = 0;
+        for (int i = 0; i < BLOCK_SIZE; i++){
+            deltas[i] = seqList[pos + i] - prev;
+            prev = seqList[pos + i];
+            maxDelta |= deltas[i];
+        }
+        int b = bitWidth(maxDelta);
+        *out = (unsigned char) b;
+        out++;
+
+        // lane l is a bit stream of 32 * b bits, word w of lane l is stored at position 4 * w + l
+        unsigned int* words = (unsigned int*) out;
+        for (int i = 0; i < 4 * b; i++)
+            words[i] = 0;
+        for (int r = 0; r < BLOCK_SIZE / 4; r++){
+            int bitPos = r * b;
+            int w = bitPos >> 5;
+            int s = bitPos & 31;
+            for (int l = 0; l < 4; l++){
+                unsigned int val = deltas[4 * r + l];
+                words[4 * w + l] |= val << s;
+                if (s + b > 32)
+                    words[4 * (w + 1) + l] |= val >> (32 - s);
+            }
+        }
+        out += 16 * b;
+        pos += BLOCK_SIZE;
+    }
+
+    // the rest is packed sequentially
+    int rest = listSize - pos;
+    if (rest > 0){
+        unsigned int maxDelta = 0;
+        for (int i = 0; i < rest; i++){
+            deltas[i] = seqList[pos + i] - prev;
+            prev = seqList[pos + i];
+            maxDelta |= deltas[i];
+        }
+        int b = bitWidth(maxDelta);
+        *out = (unsigned char) b;
+        out++;
+
+        unsigned long long buffer = 0;
+        int bufferedBits = 0;
+        for (int i = 0; i < rest; i++){
+            buffer |= ((unsigned long long) deltas[i]) << bufferedBits;
+            bufferedBits += b;
+            while (bufferedBits >= 8){
+                *out = (unsigned char) buffer;
+                out++;
+                buffer >>= 8;
+                bufferedBits -= 8;
+            }
+        }
+        if (bufferedBits > 0){
+            *out = (unsigned char) buffer;
+            out++;
+        }
+    }
+    return out - start;
+}
+
+size_t SequenceListCodec::encodedSize(const unsigned char* data, size_t listSize){
+    const unsigned char* p = data;
+    for (size_t i = 0; i < listSize / BLOCK_SIZE; i++)
+        p += 1 + 16 * (*p);
+    size_t rest = listSize % BLOCK_SIZE;
+    if (rest > 0)
+        p += 1 + ((size_t) rest * (*p) + 7) / 8;
+    return p - data;
+}
+
+void SequenceListCodec::initDecoding(const unsigned char* data, size_t listSize){
+    this->data = data;
+    this->remaining = listSize;
+    this->lastId = 0;
+}
+
+int SequenceListCodec::decodeNextBlock(unsigned int* out){
+    if (remaining == 0)
+        return 0;
+
+    int b = *data;
+    data++;
+
+    if (remaining >= BLOCK_SIZE){
+        const __m128i* words = (const __m128i*) data;
+        const __m128i mask = (b == 32) ? _mm_set1_epi32(-1) : _mm_set1_epi32((1U << b) - 1);
+        __m128i carry = _mm_set1_epi32(lastId);
+        __m128i* outVec = (__m128i*) out;
+        for (int r = 0; r < BLOCK_SIZE / 4; r++){
+            int bitPos = r * b;
+            int w = bitPos >> 5;
+            int s = bitPos & 31;
+            __m128i v = _mm_setzero_si128();
+            if (b > 0){
+                v = _mm_srl_epi32(_mm_loadu_si128(words + w), _mm_cvtsi32_si128(s));
+                if (s + b > 32)
+                    v = _mm_or_si128(v, _mm_sll_epi32(_mm_loadu_si128(words + w + 1), _mm_cvtsi32_si128(32 - s)));
+                v = _mm_and_si128(v, mask);
+            }
+            // prefix sum of the four deltas plus the last id of the previous row
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, carry);
+            _mm_store_si128(outVec + r, v);
+            carry = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+        data += 16 * b;
+        remaining -= BLOCK_SIZE;
+        lastId = out[BLOCK_SIZE - 1];
+        return BLOCK_SIZE;
+    }
+
+    int rest = remaining;
+    unsigned long long buffer = 0;
+    int bufferedBits = 0;
+    unsigned long long mask = (1ULL << b) - 1;
+    unsigned int id = lastId;
+    for (int i = 0; i < rest; i++){
+        while (bufferedBits < b){
+            buffer |= ((unsigned long long) *data) << bufferedBits;
+            data++;
+            bufferedBits += 8;
+        }
+        id += (unsigned int) (buffer & mask);
+        out[i] = id;
+        buffer >>= b;
+        bufferedBits -= b;
+    }
+    remaining = 0;
+    lastId = id;
+    return rest;
+}
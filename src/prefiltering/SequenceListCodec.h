@@ -0,0 +1,53 @@
+#ifndef SEQUENCE_LIST_CODEC_H
+#define SEQUENCE_LIST_CODEC_H
+
+//
+// Compression of the sorted sequence id lists in the index table.
+//
+// The ids are delta encoded. Each block of BLOCK_SIZE deltas is bit-packed with the bit width of its largest delta
+// in the vertical 4-lane layout of SIMD-BP128 (Lemire & Boytsov, 2015): delta i is stored in lane i % 4, so a whole block
+// is unpacked and prefix-summed with SSE2 operations, four ids at a time.
+// The rest of the list (less than BLOCK_SIZE deltas) is bit-packed sequentially.
+// Each block and the rest start with one byte containing the bit width.
+//
+
+#include <emmintrin.h>
+#include <cstddef>
+
+class SequenceListCodec {
+
+    public:
+
+        static const int BLOCK_SIZE = 128;
+
+        // upper bound of the encoded size of a list with listSize ids in byte
+        static size_t maxEncodedSize(size_t listSize);
+
+        // encode the sorted list of sequence ids, returns the number of bytes written into out
+        static size_t encode(const unsigned int* seqList, size_t listSize, unsigned char* out);
+
+        // returns the size of an encoded list in byte without decoding it
+        static size_t encodedSize(const unsigned char* data, size_t listSize);
+
+        // start decoding an encoded list
+        void initDecoding(const unsigned char* data, size_t listSize);
+
+        // decode the next block of at most BLOCK_SIZE ids into out (16 byte aligned)
+        // returns the number of decoded ids, 0 if the list is completely decoded
+        int decodeNextBlock(unsigned int* out);
+
+    private:
+
+        static int bitWidth(unsigned int maxVal);
+
+        // current position in the encoded list
+        const unsigned char* data;
+
+        // number of ids that are not decoded yet
+        size_t remaining;
+
+        // last decoded id, base for the next delta
+        unsigned int lastId;
+};
+
+#endif
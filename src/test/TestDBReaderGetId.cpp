@@ -0,0 +1,69 @@
+//
+// Checks the binary search of DBReader::getId: all keys of a database are found at their local ids,
+// keys before the first, between and after the last key are not found.
+//
+// USAGE: TestDBReaderGetId [temporary directory]
+//
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <climits>
+#include <string>
+#include <cstdio>
+
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "TestUtil.h"
+
+void removeDB(const std::string& db){
+    remove(db.c_str());
+    remove(std::string(db + ".index").c_str());
+}
+
+// keys k100010, k100020, ... so that there are missing keys between all of them
+std::string getKey(size_t i){
+    std::stringstream key;
+    key << "k" << (i + 1) * 10 + 100000;
+    return key.str();
+}
+
+int main (int argc, const char * argv[])
+{
+    std::string dir = (argc > 1) ? argv[1] : "/tmp";
+    std::string db = dir + "/TestDBReaderGetId";
+    const size_t dbSize = 1001;
+    int errors = 0;
+    // DBWriter does not overwrite databases
+    removeDB(db);
+
+    DBWriter dbw(db.c_str(), std::string(db + ".index").c_str());
+    dbw.open();
+    for (size_t i = 0; i < dbSize; i++){
+        // different lengths, so that the local ids of DBReader::SORT differ from the positions in the index
+        std::string seq = std::string(10 + (i * 7) % 23, 'A') + "\n";
+        dbw.write((char*) seq.c_str(), seq.length(), (char*) getKey(i).c_str());
+    }
+    dbw.close();
+
+    DBReader dbr(db.c_str(), std::string(db + ".index").c_str());
+    dbr.open(DBReader::SORT);
+    for (size_t id = 0; id < dbr.getSize(); id++){
+        if (dbr.getId(dbr.getDbKey(id)) != id){
+            std::cout << "Key " << dbr.getDbKey(id) << " found at " << dbr.getId(dbr.getDbKey(id)) << " instead of " << id << "\n";
+            errors++;
+        }
+    }
+    const char* missing[] = {"a", "k100005", "k100015", "k105005", "k110015", "z"};
+    for (size_t i = 0; i < sizeof(missing) / sizeof(missing[0]); i++){
+        if (dbr.getId(missing[i]) != UINT_MAX){
+            std::cout << "Missing key " << missing[i] << " found at " << dbr.getId(missing[i]) << "\n";
+            errors++;
+        }
+    }
+    dbr.close();
+
+    std::cout << dbSize << " keys\n";
+    removeDB(db);
+    return TestUtil::report(errors);
+}
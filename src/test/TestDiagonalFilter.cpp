@@ -0,0 +1,81 @@
+//
+// Checks the two-hit diagonal filter of the alignment stage on random sequences:
+// mutated copies of the query (30% substitutions, a shifted region) have to pass the filter,
+// unrelated random sequences should mostly be removed.
+// The filter object is reused for all queries and DB sequences to test the invalidation of the diagonal hits.
+//
+// USAGE: TestDiagonalFilter [number of queries] [DB sequences per query]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <string>
+
+#include "SubstitutionMatrix.h"
+#include "Sequence.h"
+#include "../alignment/DiagonalFilter.h"
+#include "TestUtil.h"
+
+std::string randomSequence(SubstitutionMatrix& m, int len){
+    std::string seq;
+    for (int i = 0; i < len; i++)
+        seq += m.int2aa[rand() % (m.alphabetSize - 1)];
+    return seq;
+}
+
+std::string mutate(SubstitutionMatrix& m, const std::string& seq, int percent){
+    std::string mutated = seq;
+    for (size_t i = 0; i < mutated.size(); i++)
+        if (rand() % 100 < percent)
+            mutated[i] = m.int2aa[rand() % (m.alphabetSize - 1)];
+    // an unrelated prefix shifts the diagonal of the homologous region
+    return randomSequence(m, rand() % 50) + mutated;
+}
+
+int main (int argc, const char * argv[])
+{
+    int queries = (argc > 1) ? atoi(argv[1]) : 50;
+    int dbSeqs = (argc > 2) ? atoi(argv[2]) : 100;
+    const int maxSeqLen = 1000;
+
+    SubstitutionMatrix subMat("../../data/blosum62.out", 2.0);
+    Sequence query(maxSeqLen, subMat.aa2int, subMat.int2aa, Sequence::AMINO_ACIDS);
+    Sequence dbSeq(maxSeqLen, subMat.aa2int, subMat.int2aa, Sequence::AMINO_ACIDS);
+    DiagonalFilter filter(&subMat, maxSeqLen);
+
+    srand(1);
+    int errors = 0;
+    int homologsPassed = 0;
+    int randomPassed = 0;
+    for (int q = 0; q < queries; q++){
+        const std::string querySeq = randomSequence(subMat, 100 + rand() % 300);
+        query.mapSequence(q, (char*) "query", querySeq.c_str());
+        filter.initQuery(&query);
+        for (int i = 0; i < dbSeqs; i++){
+            dbSeq.mapSequence(i, (char*) "db", randomSequence(subMat, 100 + rand() % 300).c_str());
+            if (filter.passes(&dbSeq))
+                randomPassed++;
+            dbSeq.mapSequence(i, (char*) "db", mutate(subMat, querySeq, 30).c_str());
+            if (filter.passes(&dbSeq))
+                homologsPassed++;
+        }
+        // the identical sequence always passes
+        dbSeq.mapSequence(0, (char*) "db", querySeq.c_str());
+        if (!filter.passes(&dbSeq)){
+            std::cout << "Query " << q << ": the query sequence does not pass the filter\n";
+            errors++;
+        }
+    }
+    const int pairs = queries * dbSeqs;
+    std::cout << homologsPassed << " of " << pairs << " mutated sequences and "
+        << randomPassed << " of " << pairs << " random sequences passed the filter\n";
+    if (homologsPassed < pairs * 0.99){
+        std::cout << "Too many mutated sequences removed\n";
+        errors++;
+    }
+    if (randomPassed > pairs * 0.2){
+        std::cout << "Too many random sequences passed\n";
+        errors++;
+    }
+    return TestUtil::report(errors);
+}
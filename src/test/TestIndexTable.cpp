@@ -97,14 +97,14 @@ int main (int argc, const char * argv[])
     std::cout << " done.\n";
 
     for (int kmerIdx = 0; kmerIdx < pow(alphabetSize, kmerSize); kmerIdx++){
-        int listSize = 0;
-        int* seqList = it->getDBSeqList(kmerIdx, &listSize);
+        size_t listSize = 0;
+        unsigned int* seqList = it->getDBSeqList(kmerIdx, &listSize);
         if (listSize > 0){
             std::cout << "\nSequence list for k-mer index " << kmerIdx << " (";
             idxer->printKmer(kmerIdx, kmerSize, sm->int2aa);
             std::cout << ")\n";
             std::cout << "size: " << listSize << "\n";
-            for (int i = 0; i < listSize-1; i++)
+            for (size_t i = 0; i < listSize-1; i++)
                 std::cout << seqList[i] << ",";
             std::cout << seqList[listSize-1] << "\n";
 
@@ -127,8 +127,8 @@ int main (int argc, const char * argv[])
         kmer = s->int_sequence + pos;
         kmerIdx = idxer->getNextKmerIndex(kmer, kmerSize);
         
-        int listSize = 0;
-        int* seqList = it->getDBSeqList(kmerIdx, &listSize);
+        size_t listSize = 0;
+        unsigned int* seqList = it->getDBSeqList(kmerIdx, &listSize);
 
         qs->addScores(seqList, listSize, 1);
     }
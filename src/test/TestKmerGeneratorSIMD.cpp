@@ -0,0 +1,122 @@
+//
+// Compares the similar k-mer lists of the SIMD array product in KmerGenerator (SSE2 and AVX2)
+// with a scalar implementation of the product with early exits on the sorted rows of the extended matrices
+// for all k-mer sizes and measures the time of the k-mer list generation.
+//
+// USAGE: TestKmerGeneratorSIMD [number of positions]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+#include "SubstitutionMatrix.h"
+#include "ExtendedSubstitutionMatrix.h"
+#include "KmerGenerator.h"
+#include "Indexer.h"
+#include "TestUtil.h"
+
+// the k-mer is split into parts of 3 and 2 residues like in KmerGenerator
+std::vector<int> getParts(int kmerSize){
+    std::vector<int> parts(kmerSize / 3, 3);
+    if (kmerSize % 3 == 1){
+        parts.back() = 2;
+        parts.push_back(2);
+    }
+    else if (kmerSize % 3 == 2)
+        parts.push_back(2);
+    return parts;
+}
+
+std::vector<std::pair<short, unsigned int> > referenceKmerList(const int* kmer, int kmerSize, short threshold, int alphabetSize,
+        ExtendedSubstitutionMatrix* three, ExtendedSubstitutionMatrix* two){
+    std::vector<int> parts = getParts(kmerSize);
+    std::vector<ExtendedSubstitutionMatrix*> matrices;
+    std::vector<unsigned int> rows;
+    std::vector<unsigned int> pows;
+    int start = 0;
+    unsigned int pow = 1;
+    for (size_t i = 0; i < parts.size(); i++){
+        matrices.push_back(parts[i] == 3 ? three : two);
+        unsigned int row = 0;
+        for (int j = parts[i] - 1; j >= 0; j--)
+            row = row * alphabetSize + kmer[start + j];
+        rows.push_back(row);
+        pows.push_back(pow);
+        for (int j = 0; j < parts[i]; j++)
+            pow *= alphabetSize;
+        start += parts[i];
+    }
+    // highest possible score of the remaining parts
+    std::vector<int> rest(parts.size(), 0);
+    for (int i = (int) parts.size() - 2; i >= 0; i--)
+        rest[i] = rest[i + 1] + matrices[i + 1]->score[rows[i + 1]][0];
+
+    std::vector<std::pair<short, unsigned int> > list;
+    for (size_t j = 0; j < matrices[0]->size; j++)
+        list.push_back(std::make_pair(matrices[0]->score[rows[0]][j], matrices[0]->index[rows[0]][j]));
+    for (size_t i = 1; i < parts.size(); i++){
+        std::vector<std::pair<short, unsigned int> > next;
+        for (size_t a = 0; a < list.size(); a++){
+            // only the first list is sorted
+            if (i == 1 && list[a].first < threshold - rest[0])
+                break;
+            for (size_t b = 0; b < matrices[i]->size; b++){
+                const short score = matrices[i]->score[rows[i]][b];
+                if (list[a].first + score < threshold - rest[i])
+                    break;
+                next.push_back(std::make_pair(list[a].first + score, list[a].second + matrices[i]->index[rows[i]][b] * pows[i]));
+            }
+        }
+        list.swap(next);
+    }
+    return list;
+}
+
+int main (int argc, const char * argv[])
+{
+    int positions = (argc > 1) ? atoi(argv[1]) : 2000;
+
+    SubstitutionMatrix subMat("../../data/blosum62.out", 8.0);
+    ExtendedSubstitutionMatrix two(subMat.subMatrix, 2, subMat.alphabetSize);
+    ExtendedSubstitutionMatrix three(subMat.subMatrix, 3, subMat.alphabetSize);
+
+    srand(1);
+    std::vector<int> seq(positions + 7);
+    for (size_t i = 0; i < seq.size(); i++)
+        seq[i] = rand() % (subMat.alphabetSize - 1);
+
+    int errors = 0;
+    const int kmerSizes[] = {4, 5, 6, 7};
+    const short thresholds[] = {45, 70, 95, 120};
+    for (int k = 0; k < 4; k++){
+        for (int avx2 = 0; avx2 < 2; avx2++){
+            KmerGenerator kmerGenerator(kmerSizes[k], subMat.alphabetSize, thresholds[k], &three, &two);
+            kmerGenerator.setAVX2(avx2 == 1);
+            size_t listLenSum = 0;
+            for (int pos = 0; pos < positions && pos < 200; pos++){
+                KmerGeneratorResult res = kmerGenerator.generateKmerList(&seq[pos]);
+                std::vector<std::pair<short, unsigned int> > reference = referenceKmerList(&seq[pos], kmerSizes[k], thresholds[k],
+                        subMat.alphabetSize, &three, &two);
+                listLenSum += res.count;
+                // the generated list is cut at its maximum length
+                bool equal = (res.count == reference.size() || (res.count > 0 && res.count < reference.size()));
+                for (size_t i = 0; equal && i < res.count; i++)
+                    equal = (res.score[i] == reference[i].first && res.index[i] == reference[i].second);
+                if (!equal){
+                    std::cout << "k = " << kmerSizes[k] << ", position " << pos << ": " << res.count << " k-mers, "
+                        << reference.size() << " k-mers in the reference list\n";
+                    errors++;
+                    break;
+                }
+            }
+
+            double start = TestUtil::now();
+            for (int pos = 0; pos < positions; pos++)
+                listLenSum += kmerGenerator.generateKmerList(&seq[pos]).count;
+            std::cout << "k = " << kmerSizes[k] << ", threshold " << thresholds[k] << ", " << (avx2 ? "AVX2" : "SSE2") << ": "
+                << (TestUtil::now() - start) / positions * 1e6 << " us per position\n";
+        }
+    }
+    return TestUtil::report(errors);
+}
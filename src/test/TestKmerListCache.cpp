@@ -0,0 +1,107 @@
+//
+// Adds and reads the similar k-mer lists of random k-mers in the KmerListCache from all threads:
+// the cached lists have to be equal to the generated lists, the memory limit has to be kept
+// and repeated k-mers have to be found in the cache. A list that does not fit into the remaining memory
+// must not stop the caching of shorter lists.
+//
+// USAGE: TestKmerListCache [cache memory in MB] [number of positions per thread]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+#include "SubstitutionMatrix.h"
+#include "ExtendedSubstitutionMatrix.h"
+#include "KmerGenerator.h"
+#include "KmerListCache.h"
+#include "Indexer.h"
+#include "TestUtil.h"
+
+int main (int argc, const char * argv[])
+{
+    size_t cacheMemory = ((argc > 1) ? strtoull(argv[1], NULL, 10) : 20) * 1024 * 1024;
+    int positions = (argc > 2) ? atoi(argv[2]) : 20000;
+    const int kmerSize = 6;
+
+    SubstitutionMatrix subMat("../../data/blosum62.out", 8.0);
+    ExtendedSubstitutionMatrix two(subMat.subMatrix, 2, subMat.alphabetSize);
+    ExtendedSubstitutionMatrix three(subMat.subMatrix, 3, subMat.alphabetSize);
+    KmerListCache cache(cacheMemory);
+
+    int threads = 1;
+#ifdef OPENMP
+    threads = omp_get_max_threads();
+#endif
+    int errors = 0;
+#pragma omp parallel for schedule(static) reduction (+: errors)
+    for (int t = 0; t < threads; t++){
+        KmerGenerator kmerGenerator(kmerSize, subMat.alphabetSize, 100, &three, &two);
+        Indexer indexer(subMat.alphabetSize, kmerSize);
+        // few different k-mers (repeated in all threads) and random k-mers
+        unsigned int seed = t;
+        int kmer[kmerSize];
+        size_t hits = 0;
+        size_t misses = 0;
+        for (int pos = 0; pos < positions; pos++){
+            const bool repeated = (pos % 2 == 0);
+            for (int i = 0; i < kmerSize; i++)
+                kmer[i] = (repeated ? (pos / 2 % 100 + i * 7) : rand_r(&seed)) % (subMat.alphabetSize - 1);
+            const unsigned int kmerIdx = indexer.int2index(kmer, 0, kmerSize);
+            KmerGeneratorResult cached;
+            const bool hit = cache.get(kmerIdx, &cached);
+            KmerGeneratorResult list = kmerGenerator.generateKmerList(kmer);
+            if (hit){
+                hits++;
+                bool equal = (cached.count == list.count);
+                for (size_t i = 0; equal && i < list.count; i++)
+                    equal = (cached.score[i] == list.score[i] && cached.index[i] == list.index[i]);
+                if (!equal){
+#pragma omp critical
+                    std::cout << "Thread " << t << ": the cached list of the k-mer " << kmerIdx << " differs from the generated list\n";
+                    errors++;
+                }
+            }
+            else {
+                misses++;
+                cache.add(kmerIdx, list);
+            }
+        }
+        cache.addStatistics(hits, misses);
+    }
+
+    std::cout << threads << " threads, " << cache.getListsNum() << " cached lists, " << (cache.getMemory() >> 20) << " MB, "
+        << cache.getHits() << " hits, " << cache.getMisses() << " misses\n";
+    if (cache.getMemory() > cacheMemory){
+        std::cout << "The cache uses more than " << (cacheMemory >> 20) << " MB\n";
+        errors++;
+    }
+    // each thread reads 100 different repeated k-mers positions / 2 times
+    if (cache.getHits() < (size_t) threads * (positions / 2 - 100)){
+        std::cout << "Too few cache hits for the repeated k-mers\n";
+        errors++;
+    }
+
+    // a list larger than the remaining memory is skipped, the following shorter lists are still cached
+    const size_t smallCount = 100;
+    std::vector<unsigned int> index(cacheMemory / sizeof(unsigned int));
+    std::vector<short> score(index.size());
+    KmerListCache smallCache(smallCount * 100 * (sizeof(unsigned int) + sizeof(short)));
+    KmerGeneratorResult list;
+    list.index = &index[0];
+    list.score = &score[0];
+    list.count = index.size();
+    smallCache.add(0, list);
+    list.count = smallCount;
+    for (unsigned int kmerIdx = 1; kmerIdx <= 10; kmerIdx++)
+        smallCache.add(kmerIdx, list);
+    if (smallCache.getListsNum() != 10){
+        std::cout << smallCache.getListsNum() << " instead of 10 short lists cached after a too long list\n";
+        errors++;
+    }
+    return TestUtil::report(errors);
+}
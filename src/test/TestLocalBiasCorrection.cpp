@@ -0,0 +1,82 @@
+//
+// Compares the sliding window bias correction (LocalBiasCorrection) with the direct computation
+// of the window sum and the background score for each position and measures the time of both
+// for random sequences and low complexity sequences.
+//
+// USAGE: TestLocalBiasCorrection [sequence length] [number of sequences]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+#include "SubstitutionMatrix.h"
+#include "LocalBiasCorrection.h"
+#include "TestUtil.h"
+
+// direct computation, O(L * (window size + alphabet size))
+void referenceBiasCorrection(BaseMatrix* m, const int* seq, int L, float* deltaS){
+    const int windowSize = LocalBiasCorrection::WINDOW_SIZE;
+    if (L < windowSize + 1){
+        for (int i = 0; i < L; i++)
+            deltaS[i] = 0.0;
+        return;
+    }
+    for (int i = 0; i < L; i++){
+        float deltaS_i = 0.0;
+        const int minPos = std::max(0, (i - windowSize/2));
+        const int maxPos = std::min(L, (i + windowSize/2));
+        for (int j = minPos; j < maxPos; j++)
+            if (j != i)
+                deltaS_i += m->subMatrix[seq[i]][seq[j]];
+        deltaS_i /= -1.0 * (maxPos - minPos);
+        for (int a = 0; a < m->alphabetSize; a++)
+            deltaS_i += m->pBack[a] * m->subMatrix[seq[i]][a];
+        deltaS[i] = deltaS_i;
+    }
+}
+
+int main (int argc, const char * argv[])
+{
+    int L = (argc > 1) ? atoi(argv[1]) : 2000;
+    int seqs = (argc > 2) ? atoi(argv[2]) : 2000;
+
+    SubstitutionMatrix subMat("../../data/blosum62.out", 8.0);
+    LocalBiasCorrection biasCorrection(&subMat);
+
+    srand(1);
+    std::vector<int> seq(L);
+    std::vector<float> deltaS(L);
+    std::vector<float> reference(L);
+    int errors = 0;
+    double timeReference = 0.0;
+    double timeSliding = 0.0;
+    for (int s = 0; s < seqs; s++){
+        // random sequences, sequences with low complexity regions and short sequences
+        const int len = (s % 10 == 0) ? rand() % 60 : L;
+        for (int i = 0; i < len; i++)
+            seq[i] = (s % 3 == 1 && i % 200 < 50) ? (i % 2) * 5 : rand() % (subMat.alphabetSize - 1);
+
+        double start = TestUtil::now();
+        referenceBiasCorrection(&subMat, &seq[0], len, &reference[0]);
+        timeReference += TestUtil::now() - start;
+        start = TestUtil::now();
+        biasCorrection.calc(&seq[0], len, &deltaS[0]);
+        timeSliding += TestUtil::now() - start;
+
+        // the background score is summed up in a different order
+        for (int i = 0; i < len; i++){
+            if (fabs(deltaS[i] - reference[i]) > 1e-4){
+                std::cout << "Sequence " << s << ", position " << i << ": " << deltaS[i] << " instead of " << reference[i] << "\n";
+                errors++;
+                break;
+            }
+        }
+    }
+    std::cout << seqs << " sequences of length " << L << "\n";
+    std::cout << "Direct computation: " << timeReference / seqs * 1e6 << " us per sequence, sliding window: "
+        << timeSliding / seqs * 1e6 << " us per sequence\n";
+    return TestUtil::report(errors);
+}
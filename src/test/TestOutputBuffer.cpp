@@ -0,0 +1,121 @@
+//
+// Compares the number conversions of the OutputBuffer with snprintf for random floats, doubles and integers
+// and special values, and measures the time of writing prefiltering result lines with the OutputBuffer
+// and with a std::stringstream.
+//
+// USAGE: TestOutputBuffer [number of values]
+//
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <string>
+
+#include "OutputBuffer.h"
+#include "TestUtil.h"
+
+int errors = 0;
+
+void compare(OutputBuffer& buffer, const char* format, int precision, double value){
+    char expected[512];
+    snprintf(expected, sizeof(expected), format, precision, value);
+    std::string result(buffer.getData(), buffer.getLength());
+    if (result != expected){
+        if (errors < 20)
+            std::cout << format << " (" << precision << ") of " << value << ": " << result << " instead of " << expected << "\n";
+        errors++;
+    }
+    buffer.clear();
+}
+
+void compareAll(OutputBuffer& buffer, double value){
+    for (int precision = 1; precision <= 8; precision++){
+        buffer.appendFloat(value, precision);
+        compare(buffer, "%.*g", precision, value);
+    }
+    for (int decimals = 0; decimals <= 4; decimals++){
+        buffer.appendFixed(value, decimals);
+        compare(buffer, "%.*f", decimals, value);
+        buffer.appendScientific(value, decimals);
+        compare(buffer, "%.*e", decimals, value);
+    }
+}
+
+int main (int argc, const char * argv[])
+{
+    int values = (argc > 1) ? atoi(argv[1]) : 1000000;
+    OutputBuffer buffer(1);
+
+    // special values, ties, powers of ten and rounding carries
+    const double special[] = {0.0, -0.0, 1.0, -1.0, 0.5, 1.5, 2.5, 0.0625, 1.0625, 100000.5, 1.234375, 999999.5,
+        9.999999f, 9.9999995f, 0.00001, 0.0001, 123456789.0, 1e-300, 4.9e-324, 1.7e308, 1.0 / 0.0, -1.0 / 0.0};
+    for (size_t i = 0; i < sizeof(special) / sizeof(double); i++)
+        compareAll(buffer, special[i]);
+    for (int e = -30; e <= 30; e++){
+        compareAll(buffer, pow(10.0, e));
+        compareAll(buffer, nextafter(pow(10.0, e), 0.0));
+    }
+
+    srand(1);
+    for (int i = 0; i < values; i++){
+        // floats (z-scores, coverages) of different magnitudes and doubles (e-values)
+        const float f = (float) ((rand() / (double) RAND_MAX - 0.3) * pow(10.0, rand() % 16 - 8));
+        compareAll(buffer, f);
+        const double d = rand() / (double) RAND_MAX * pow(10.0, rand() % 600 - 300);
+        buffer.appendScientific(d, 3);
+        compare(buffer, "%.*e", 3, d);
+
+        const long long n = ((long long) rand() << 31 | rand()) * ((i % 2) ? 1 : -1) >> (rand() % 62);
+        buffer.appendInt(n);
+        char expected[32];
+        snprintf(expected, sizeof(expected), "%lld", n);
+        if (std::string(buffer.getData(), buffer.getLength()) != expected){
+            std::cout << "%lld of " << expected << ": " << std::string(buffer.getData(), buffer.getLength()) << "\n";
+            errors++;
+        }
+        buffer.clear();
+    }
+
+    // prefiltering result lines: key, z-score, prefiltering score
+    const int lines = values;
+    double start = TestUtil::now();
+    std::stringstream ss;
+    size_t streamLength = 0;
+    for (int i = 0; i < lines; i++){
+        ss << "UniRef50_" << i << "\t" << (i % 1000) * 0.137f << "\t" << (unsigned short) (i % 500) << "\n";
+        if (i % 300 == 299){
+            streamLength += ss.str().length();
+            ss.str("");
+        }
+    }
+    streamLength += ss.str().length();
+    const double timeStream = TestUtil::now() - start;
+
+    start = TestUtil::now();
+    size_t bufferLength = 0;
+    for (int i = 0; i < lines; i++){
+        buffer.appendString("UniRef50_", 9);
+        buffer.appendInt(i);
+        buffer.appendChar('\t');
+        buffer.appendFloat((i % 1000) * 0.137f);
+        buffer.appendChar('\t');
+        buffer.appendUInt((unsigned short) (i % 500));
+        buffer.appendChar('\n');
+        if (i % 300 == 299){
+            bufferLength += buffer.getLength();
+            buffer.clear();
+        }
+    }
+    bufferLength += buffer.getLength();
+    const double timeBuffer = TestUtil::now() - start;
+    if (streamLength != bufferLength){
+        std::cout << "The result lines have " << bufferLength << " characters instead of " << streamLength << "\n";
+        errors++;
+    }
+
+    std::cout << lines << " result lines: stringstream " << timeStream << " s, OutputBuffer " << timeBuffer << " s\n";
+    return TestUtil::report(errors);
+}
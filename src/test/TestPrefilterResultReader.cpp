@@ -0,0 +1,159 @@
+//
+// Writes a prefiltering result list in the text and in the binary format into a temporary database
+// and checks that the PrefilterResultReader reads the same hits from both lists and copies them unchanged.
+//
+// USAGE: TestPrefilterResultReader [temporary directory]
+//
+
+#include <iostream>
+#include <sstream>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <cstdio>
+
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "OutputBuffer.h"
+#include "PrefilterFormat.h"
+#include "PrefilterResultReader.h"
+#include "TestUtil.h"
+
+void removeDB(const std::string& db){
+    remove(db.c_str());
+    remove(std::string(db + ".index").c_str());
+}
+
+int main (int argc, const char * argv[])
+{
+    std::string dir = (argc > 1) ? argv[1] : "/tmp";
+    std::string targetDB = dir + "/TestPrefilterResultReader_target";
+    std::string prefDB = dir + "/TestPrefilterResultReader_pref";
+    const size_t targetDbSize = 50;
+    int errors = 0;
+    // DBWriter does not overwrite databases
+    removeDB(targetDB);
+    removeDB(prefDB);
+
+    // target sequences of different lengths, the NOSORT ids follow the order of the keys
+    DBWriter tdbw(targetDB.c_str(), std::string(targetDB + ".index").c_str());
+    tdbw.open();
+    for (size_t i = 0; i < targetDbSize; i++){
+        std::stringstream key;
+        key << "t" << i;
+        std::string seq = std::string(10 + (i * 7) % 23, 'A' + i % 20) + "\n";
+        tdbw.write((char*) seq.c_str(), seq.length(), (char*) key.str().c_str());
+    }
+    tdbw.close();
+
+    DBReader tdbr(targetDB.c_str(), std::string(targetDB + ".index").c_str());
+    tdbr.open(DBReader::NOSORT);
+
+    // the same hits in both formats, the binary list in the way of Prefiltering::writePrefilterOutput
+    OutputBuffer text;
+    OutputBuffer binary;
+    PrefilterFormat::appendHeader(&binary, tdbr.getSize());
+    const size_t hits = 20;
+    for (size_t i = 0; i < hits; i++){
+        const size_t id = (i * 13) % targetDbSize;
+        const float zScore = 1000.0f / (i + 1);
+        const unsigned short prefScore = (unsigned short) (5000 - i * 37);
+        text.appendString(tdbr.getDbKey(id));
+        text.appendChar('\t');
+        text.appendFloat(zScore);
+        text.appendChar('\t');
+        text.appendUInt(prefScore);
+        text.appendChar('\n');
+        PrefilterFormat::appendRecord(&binary, id, zScore, prefScore);
+    }
+
+    DBWriter pdbw(prefDB.c_str(), std::string(prefDB + ".index").c_str());
+    pdbw.open();
+    pdbw.write(text.getData(), text.getLength(), (char*) "text");
+    pdbw.write(binary.getData(), binary.getLength(), (char*) "binary");
+    pdbw.write((char*) "", 0, (char*) "empty");
+    pdbw.close();
+
+    DBReader pdbr(prefDB.c_str(), std::string(prefDB + ".index").c_str());
+    pdbr.open(DBReader::NOSORT);
+    char* textList = pdbr.getDataByDBKey((char*) "text");
+    char* binaryList = pdbr.getDataByDBKey((char*) "binary");
+    size_t textSize = 0;
+    size_t binarySize = 0;
+    for (size_t i = 0; i < pdbr.getSize(); i++){
+        if (strcmp(pdbr.getDbKey(i), "text") == 0)
+            textSize = pdbr.getDataSize(i);
+        else if (strcmp(pdbr.getDbKey(i), "binary") == 0)
+            binarySize = pdbr.getDataSize(i);
+    }
+
+    PrefilterResultReader textReader(&tdbr);
+    PrefilterResultReader binaryReader(&tdbr);
+    textReader.init(textList, textSize);
+    binaryReader.init(binaryList, binarySize);
+    if (textReader.isBinary() || !binaryReader.isBinary()){
+        std::cout << "Wrong format of the result lists\n";
+        errors++;
+    }
+    size_t read = 0;
+    while (true){
+        const bool hasText = textReader.next();
+        const bool hasBinary = binaryReader.next();
+        if (hasText != hasBinary){
+            std::cout << "The result lists have a different number of hits\n";
+            errors++;
+            break;
+        }
+        if (!hasText)
+            break;
+        if (strcmp(textReader.getTargetKey(), binaryReader.getTargetKey()) != 0
+                || textReader.getTargetData() != binaryReader.getTargetData()
+                // the text format keeps 6 significant digits of the z-score
+                || fabs(textReader.getZscore() - binaryReader.getZscore()) > 1e-5 * binaryReader.getZscore()
+                // the split results are merged on the printed z-scores, they have to be equal
+                || textReader.getPrintedZscore() != binaryReader.getPrintedZscore()
+                || textReader.getPrefScore() != binaryReader.getPrefScore()){
+            std::cout << "Hit " << read << ": " << textReader.getTargetKey() << " " << textReader.getZscore() << " " << textReader.getPrefScore()
+                << " instead of " << binaryReader.getTargetKey() << " " << binaryReader.getZscore() << " " << binaryReader.getPrefScore() << "\n";
+            errors++;
+        }
+        read++;
+    }
+    if (read != hits){
+        std::cout << read << " hits read instead of " << hits << "\n";
+        errors++;
+    }
+
+    // copying the hits reproduces the lists (Prefiltering::mergeSplits), without a target database
+    char* lists[2] = {textList, binaryList};
+    size_t sizes[2] = {textSize, binarySize};
+    for (int i = 0; i < 2; i++){
+        PrefilterResultReader copyReader(NULL);
+        copyReader.init(lists[i], sizes[i]);
+        OutputBuffer copy;
+        if (copyReader.isBinary())
+            PrefilterFormat::appendHeader(&copy, targetDbSize);
+        while (copyReader.next())
+            copy.appendString(copyReader.getHit(), copyReader.getHitLength());
+        if (copy.getLength() != sizes[i] || memcmp(copy.getData(), lists[i], sizes[i]) != 0){
+            std::cout << "The copy of the " << (copyReader.isBinary() ? "binary" : "text") << " list differs\n";
+            errors++;
+        }
+    }
+
+    PrefilterResultReader emptyReader(&tdbr);
+    emptyReader.init(pdbr.getDataByDBKey((char*) "empty"), 0);
+    if (emptyReader.next()){
+        std::cout << "Hit in an empty result list\n";
+        errors++;
+    }
+
+    std::cout << "text list " << textSize << " byte, binary list " << binarySize << " byte\n";
+
+    pdbr.close();
+    tdbr.close();
+    removeDB(targetDB);
+    removeDB(prefDB);
+    return TestUtil::report(errors);
+}
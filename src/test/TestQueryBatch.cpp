@@ -0,0 +1,94 @@
+//
+// Compares the batched matching of QueryTemplateMatcher (addBatchQuery/matchBatch) with matching the queries one by one.
+// The target database is the query database, the hit lists have to be identical.
+//
+// USAGE: TestQueryBatch <ffindexDB> [batch size] [number of queries]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <climits>
+#include <string>
+#include <vector>
+
+#include "../commons/DBReader.h"
+#include "../commons/SubstitutionMatrix.h"
+#include "../prefiltering/Prefiltering.h"
+#include "TestUtil.h"
+
+int main (int argc, const char * argv[])
+{
+    if (argc < 2){
+        std::cout << "USAGE: TestQueryBatch <ffindexDB> [batch size] [number of queries]\n";
+        return EXIT_FAILURE;
+    }
+    Debug::setDebugLevel(Debug::WARNING);
+    std::string db(argv[1]);
+    std::string dbIndex = db + ".index";
+    int batchSize = (argc > 2) ? atoi(argv[2]) : 16;
+    size_t queries = (argc > 3) ? strtoull(argv[3], NULL, 10) : 1000;
+    const int kmerSize = 6;
+    const short kmerThr = 110;
+
+    SubstitutionMatrix subMat("../../data/blosum62.out", 8.0);
+    ExtendedSubstitutionMatrix _2merSubMatrix(subMat.subMatrix, 2, subMat.alphabetSize);
+    ExtendedSubstitutionMatrix _3merSubMatrix(subMat.subMatrix, 3, subMat.alphabetSize);
+    Sequence* seq = new Sequence(50000, subMat.aa2int, subMat.int2aa, Sequence::AMINO_ACIDS);
+
+    DBReader qdbr(db.c_str(), dbIndex.c_str());
+    qdbr.open(DBReader::NOSORT);
+    queries = std::min(queries, qdbr.getSize());
+    DBReader tdbr(db.c_str(), dbIndex.c_str());
+    tdbr.open(DBReader::SORT);
+
+    IndexTable* indexTable = Prefiltering::getIndexTable(&tdbr, &seq, 1, subMat.alphabetSize, kmerSize, 0, tdbr.getSize());
+    QueryTemplateMatcher single(&subMat, &_2merSubMatrix, &_3merSubMatrix, indexTable, tdbr.getSeqLens(), kmerThr,
+            1e-5, kmerSize, tdbr.getSize(), true, 50000, 5.0);
+    QueryTemplateMatcher batched(&subMat, &_2merSubMatrix, &_3merSubMatrix, indexTable, tdbr.getSeqLens(), kmerThr,
+            1e-5, kmerSize, tdbr.getSize(), true, 50000, 5.0, batchSize);
+
+    // results of the single queries
+    std::vector<std::vector<size_t> > hits(queries);
+    std::vector<std::vector<unsigned short> > scores(queries);
+    double start = TestUtil::now();
+    for (size_t id = 0; id < queries; id++){
+        seq->mapSequence(id, qdbr.getDbKey(id), qdbr.getData(id));
+        std::pair<hit_t *, size_t> res = single.matchQuery(seq, tdbr.getId(seq->getDbKey()));
+        for (size_t i = 0; i < res.second; i++){
+            hits[id].push_back(res.first[i].seqId);
+            scores[id].push_back(res.first[i].prefScore);
+        }
+    }
+    double singleTime = TestUtil::now() - start;
+
+    int errors = 0;
+    start = TestUtil::now();
+    for (size_t batchStart = 0; batchStart < queries; batchStart += batchSize){
+        const size_t batchEnd = std::min(batchStart + batchSize, queries);
+        for (size_t id = batchStart; id < batchEnd; id++){
+            seq->mapSequence(id, qdbr.getDbKey(id), qdbr.getData(id));
+            batched.addBatchQuery(seq, tdbr.getId(seq->getDbKey()));
+        }
+        batched.matchBatch();
+        for (size_t id = batchStart; id < batchEnd; id++){
+            std::pair<hit_t *, size_t> res = batched.getBatchResult(id - batchStart);
+            bool same = (res.second == hits[id].size());
+            for (size_t i = 0; same && i < res.second; i++)
+                same = (res.first[i].seqId == hits[id][i] && res.first[i].prefScore == scores[id][i]);
+            if (!same){
+                std::cout << "Different hits for query " << qdbr.getDbKey(id) << "\n";
+                errors++;
+            }
+        }
+    }
+    double batchTime = TestUtil::now() - start;
+
+    std::cout << queries << " queries, batch size " << batchSize << "\n";
+    std::cout << "Single queries: " << singleTime << " s, batched: " << batchTime << " s\n";
+
+    delete indexTable;
+    delete seq;
+    tdbr.close();
+    qdbr.close();
+    return TestUtil::report(errors);
+}
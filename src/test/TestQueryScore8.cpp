@@ -0,0 +1,133 @@
+//
+// Compares the hit lists of the 8-bit scores (QueryScoreGlobal8) with the 16-bit scores (QueryScoreGlobal)
+// for small scores that do not saturate: the 16-bit k-mer match scores are 2^(KMER_SCORE_SHIFT_8BIT - KMER_SCORE_SHIFT)
+// times the 8-bit scores, so the hits are the same up to the rounding of the score thresholds (at most 5% different hits).
+// The 8-bit results of all instruction sets and of the sparse and full score array scans have to be identical.
+// Measures the time of addScores and getResult for both widths.
+//
+// USAGE: TestQueryScore8 [DB size] [number of queries]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <climits>
+#include <stdint.h>
+#include <vector>
+
+#include "../prefiltering/QueryScoreGlobal.h"
+#include "../prefiltering/QueryScoreGlobal8.h"
+#include "TestUtil.h"
+
+bool compareSeqIds(const hit_t& first, const hit_t& second){
+    return first.seqId < second.seqId;
+}
+
+// number of hits that are only in one of the lists (sorted by sequence id), the scores of the common hits have to be equal
+size_t differentHits(std::pair<hit_t *, size_t> res, std::vector<hit_t>& reference, unsigned short scale){
+    size_t diff = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < res.second || j < reference.size()){
+        if (j == reference.size() || (i < res.second && res.first[i].seqId < reference[j].seqId)){
+            diff++;
+            i++;
+        }
+        else if (i == res.second || reference[j].seqId < res.first[i].seqId){
+            diff++;
+            j++;
+        }
+        else {
+            if (res.first[i].prefScore * scale != reference[j].prefScore)
+                return SIZE_MAX;
+            i++;
+            j++;
+        }
+    }
+    return diff;
+}
+
+int main (int argc, const char * argv[])
+{
+    // not a multiple of 64 to test the rest of the AVX loops
+    size_t dbSize = (argc > 1) ? strtoull(argv[1], NULL, 10) : 4000003;
+    int queries = (argc > 2) ? atoi(argv[2]) : 20;
+    const unsigned short scale = 1 << (QueryScore::KMER_SCORE_SHIFT_8BIT - QueryScore::KMER_SCORE_SHIFT);
+
+    unsigned short* seqLens = TestUtil::getSeqLens(dbSize);
+
+    QueryScore* scores16 = new QueryScoreGlobal(dbSize, seqLens, 6, 100, 1e-4, 3.0);
+    QueryScore* scores8 = new QueryScoreGlobal8(dbSize, seqLens, 6, 100, 1e-4, 3.0);
+    QueryScore* dense8 = new QueryScoreGlobal8(dbSize, seqLens, 6, 100, 1e-4, 3.0);
+    dense8->setSparseReset(false);
+    const int maxLevel = QueryScore::getSupportedSimdLevel();
+
+    srand(1);
+    int errors = 0;
+    double time16 = 0.0;
+    double time8 = 0.0;
+    std::vector<hit_t> reference;
+    std::vector<hit_t> reference8;
+    size_t diffSum = 0;
+    for (int q = 0; q < queries; q++){
+        // sparse and dense queries, a few matches of score <= 8 per sequence, the scores do not saturate
+        const int lists = (q % 2 == 0) ? 200 : 4000;
+        std::vector<std::vector<unsigned int> > seqLists(lists);
+        std::vector<unsigned short> kmerScores(lists);
+        for (int l = 0; l < lists; l++){
+            size_t listSize = rand() % 1000;
+            TestUtil::appendRandomSeqList(seqLists[l], listSize, dbSize);
+            kmerScores[l] = 1 + rand() % 8;
+        }
+        const unsigned int identityId = (q % 4 < 2) ? UINT_MAX : rand() % dbSize;
+
+        double start = TestUtil::now();
+        scores16->reset();
+        for (int l = 0; l < lists; l++)
+            scores16->addScores(&seqLists[l][0], seqLists[l].size(), kmerScores[l] * scale);
+        scores16->setPrefilteringThresholds();
+        std::pair<hit_t *, size_t> res = scores16->getResult(300, identityId);
+        time16 += TestUtil::now() - start;
+        reference.assign(res.first, res.first + res.second);
+        std::sort(reference.begin(), reference.end(), compareSeqIds);
+
+        dense8->reset();
+        for (int l = 0; l < lists; l++)
+            dense8->addScores(&seqLists[l][0], seqLists[l].size(), kmerScores[l]);
+        start = TestUtil::now();
+        scores8->reset();
+        for (int l = 0; l < lists; l++)
+            scores8->addScores(&seqLists[l][0], seqLists[l].size(), kmerScores[l]);
+        scores8->setPrefilteringThresholds();
+        res = scores8->getResult(300, identityId);
+        time8 += TestUtil::now() - start;
+        std::sort(res.first, res.first + res.second, compareSeqIds);
+        const size_t diff = differentHits(res, reference, scale);
+        diffSum += diff;
+        if (diff > reference.size() / 20){
+            std::cout << "Query " << q << ": 8-bit scores return " << res.second << " hits, 16-bit scores " << reference.size() << " hits\n";
+            errors++;
+        }
+        reference8.assign(res.first, res.first + res.second);
+
+        dense8->setPrefilteringThresholds();
+        for (int level = 0; level <= maxLevel; level++){
+            dense8->setSimdLevel(level);
+            res = dense8->getResult(300, identityId);
+            std::sort(res.first, res.first + res.second, compareSeqIds);
+            if (differentHits(res, reference8, 1) != 0){
+                std::cout << "Query " << q << ": full scan of the 8-bit scores (instruction set " << level << ") returns "
+                    << res.second << " hits, sparse scan " << reference8.size() << " hits\n";
+                errors++;
+            }
+        }
+    }
+    std::cout << "DB size " << dbSize << ", " << queries << " queries\n";
+    std::cout << diffSum << " hits different from the 16-bit scores (rounding of the thresholds)\n";
+    std::cout << "16-bit scores: " << time16 << " s, 8-bit scores: " << time8 << " s\n";
+
+    delete scores16;
+    delete scores8;
+    delete dense8;
+    delete[] seqLens;
+    return TestUtil::report(errors);
+}
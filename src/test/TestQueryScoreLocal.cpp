@@ -0,0 +1,95 @@
+//
+// Compares the scores of QueryScoreSemiLocal with a simple implementation of the local score
+// (best run of k-mer matches along the query, the run drops by the score drop per query position between the matches).
+// All DB sequences have the same length, so the hits are all sequences with a score above one threshold.
+// The score object is reused for all queries to test the reset of the sparse mode.
+//
+// USAGE: TestQueryScoreLocal [DB size] [number of queries]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <climits>
+#include <vector>
+
+#include "../prefiltering/QueryScoreSemiLocal.h"
+#include "TestUtil.h"
+
+int main (int argc, const char * argv[])
+{
+    size_t dbSize = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+    int queries = (argc > 2) ? atoi(argv[2]) : 20;
+    const int drop = QueryScoreSemiLocal::DEFAULT_SCORE_DROP;
+
+    unsigned short* seqLens = new unsigned short[dbSize];
+    for (size_t i = 0; i < dbSize; i++)
+        seqLens[i] = 300;
+
+    QueryScore* localScore = new QueryScoreSemiLocal(dbSize, seqLens, 6, 100, 1e-4, 2.0);
+
+    srand(1);
+    int errors = 0;
+    std::vector<unsigned int> seqList;
+    std::vector<int> runScore(dbSize);
+    std::vector<int> lastPos(dbSize);
+    std::vector<int> bestScore(dbSize);
+    std::vector<char> isHit(dbSize);
+    for (int q = 0; q < queries; q++){
+        std::fill(runScore.begin(), runScore.end(), 0);
+        std::fill(lastPos.begin(), lastPos.end(), 0);
+        std::fill(bestScore.begin(), bestScore.end(), 0);
+        localScore->reset();
+        // few and many matching DB sequences, some DB sequences match in a region of the query
+        const int queryLen = 100 + rand() % 400;
+        const size_t listSize = (q % 2 == 0) ? 2 : 2000;
+        const size_t regionSeqs = 50;
+        for (int pos = 0; pos < queryLen; pos++){
+            for (int l = 0; l < 3; l++){
+                seqList.clear();
+                TestUtil::appendRandomSeqList(seqList, listSize, dbSize);
+                if (pos > queryLen / 3 && pos < queryLen / 2 && rand() % 3 == 0)
+                    seqList.push_back(rand() % regionSeqs);
+                // the lists of the index table contain no duplicates
+                std::sort(seqList.begin(), seqList.end());
+                seqList.erase(std::unique(seqList.begin(), seqList.end()), seqList.end());
+                const unsigned short score = 20 + rand() % 20;
+                localScore->addScores(&seqList[0], seqList.size(), score, pos);
+                for (size_t i = 0; i < seqList.size(); i++){
+                    const unsigned int seqId = seqList[i];
+                    runScore[seqId] = std::max(0, runScore[seqId] - drop * (pos - lastPos[seqId])) + score;
+                    lastPos[seqId] = pos;
+                    bestScore[seqId] = std::max(bestScore[seqId], runScore[seqId]);
+                }
+            }
+        }
+        localScore->setPrefilteringThresholds();
+        std::pair<hit_t *, size_t> res = localScore->getResult(queryLen, UINT_MAX);
+
+        // the scores of the hits are the local scores, all other sequences have lower scores
+        std::fill(isHit.begin(), isHit.end(), 0);
+        int minHitScore = INT_MAX;
+        for (size_t i = 0; i < res.second; i++){
+            const size_t seqId = res.first[i].seqId;
+            isHit[seqId] = 1;
+            minHitScore = std::min(minHitScore, (int) res.first[i].prefScore);
+            if (res.first[i].prefScore != bestScore[seqId]){
+                std::cout << "Query " << q << ": score " << res.first[i].prefScore << " of sequence " << seqId
+                    << " instead of " << bestScore[seqId] << "\n";
+                errors++;
+                break;
+            }
+        }
+        for (size_t seqId = 0; seqId < dbSize; seqId++){
+            if (isHit[seqId] == 0 && bestScore[seqId] >= minHitScore){
+                std::cout << "Query " << q << ": sequence " << seqId << " with score " << bestScore[seqId] << " is missing\n";
+                errors++;
+                break;
+            }
+        }
+        std::cout << "Query " << q << ": " << res.second << " hits\n";
+    }
+
+    delete localScore;
+    delete[] seqLens;
+    return TestUtil::report(errors);
+}
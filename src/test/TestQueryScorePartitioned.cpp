@@ -0,0 +1,89 @@
+//
+// Compares the scores and results of QueryScorePartitioned with QueryScoreGlobal for random sequence lists
+// and measures the time of the score updates of both.
+//
+// USAGE: TestQueryScorePartitioned [DB size] [number of queries] [score updates per query / DB size]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <algorithm>
+
+#include "../prefiltering/QueryScoreGlobal.h"
+#include "../prefiltering/QueryScorePartitioned.h"
+#include "TestUtil.h"
+
+int main (int argc, const char * argv[])
+{
+    size_t dbSize = (argc > 1) ? strtoull(argv[1], NULL, 10) : 300000;
+    int queries = (argc > 2) ? atoi(argv[2]) : 10;
+    double density = (argc > 3) ? atof(argv[3]) : 1.0;
+    // k-mer lists per query and their mean length
+    const int lists = 20000;
+    const size_t meanListSize = std::max((size_t) 1, (size_t) (density * dbSize / lists));
+
+    unsigned short* seqLens = TestUtil::getSeqLens(dbSize);
+    srand(1);
+
+    QueryScore* global = new QueryScoreGlobal(dbSize, seqLens, 6, 100, 1e-4, 5.0);
+    QueryScore* partitioned = new QueryScorePartitioned(dbSize, seqLens, 6, 100, 1e-4, 5.0);
+
+    std::vector<unsigned int> seqList;
+    std::vector<unsigned short> listScores;
+    std::vector<size_t> listStarts;
+    int errors = 0;
+    double timeGlobal = 0.0;
+    double timePartitioned = 0.0;
+    for (int q = 0; q < queries; q++){
+        // sorted sequence lists with random ids as in the index table, scores up to 40 (high enough to saturate some scores)
+        seqList.clear();
+        listScores.clear();
+        listStarts.clear();
+        for (int l = 0; l < lists; l++){
+            listStarts.push_back(seqList.size());
+            size_t listSize = rand() % (2 * meanListSize);
+            size_t start = seqList.size();
+            TestUtil::appendRandomSeqList(seqList, listSize, dbSize);
+            std::sort(seqList.begin() + start, seqList.end());
+            listScores.push_back(rand() % 40);
+        }
+        listStarts.push_back(seqList.size());
+
+        global->reset();
+        partitioned->reset();
+        double t = TestUtil::now();
+        for (int l = 0; l < lists; l++)
+            global->addScores(&seqList[listStarts[l]], listStarts[l+1] - listStarts[l], listScores[l]);
+        global->flushScores();
+        timeGlobal += TestUtil::now() - t;
+        t = TestUtil::now();
+        for (int l = 0; l < lists; l++)
+            partitioned->addScores(&seqList[listStarts[l]], listStarts[l+1] - listStarts[l], listScores[l]);
+        partitioned->flushScores();
+        timePartitioned += TestUtil::now() - t;
+
+        global->setPrefilteringThresholds();
+        partitioned->setPrefilteringThresholds();
+        std::pair<hit_t*, size_t> resGlobal = global->getResult(300, UINT_MAX);
+        std::pair<hit_t*, size_t> resPartitioned = partitioned->getResult(300, UINT_MAX);
+        if (resGlobal.second != resPartitioned.second){
+            std::cout << "Query " << q << ": " << resGlobal.second << " global hits, " << resPartitioned.second << " partitioned hits\n";
+            errors++;
+            continue;
+        }
+        for (size_t i = 0; i < resGlobal.second; i++){
+            if (resGlobal.first[i].prefScore != resPartitioned.first[i].prefScore || resGlobal.first[i].zScore != resPartitioned.first[i].zScore){
+                std::cout << "Query " << q << ": different hit at position " << i << "\n";
+                errors++;
+                break;
+            }
+        }
+    }
+    std::cout << "DB size " << dbSize << ", " << seqList.size() << " score updates per query\n";
+    std::cout << "QueryScoreGlobal: " << timeGlobal << " s, QueryScorePartitioned: " << timePartitioned << " s\n";
+
+    delete global;
+    delete partitioned;
+    delete[] seqLens;
+    return TestUtil::report(errors);
+}
@@ -0,0 +1,73 @@
+//
+// Compares the hit lists of QueryScore::getResult for all instruction sets supported by the CPU (SSE2, AVX2, AVX-512)
+// on random scores and measures the time of setPrefilteringThresholds and getResult.
+//
+// USAGE: TestQueryScoreSIMD [DB size] [number of queries]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <climits>
+#include <vector>
+
+#include "../prefiltering/QueryScoreGlobal.h"
+#include "TestUtil.h"
+
+const char* simdNames[] = {"SSE2", "AVX2", "AVX-512"};
+
+int main (int argc, const char * argv[])
+{
+    // not a multiple of 32 to test the rest of the AVX loops
+    size_t dbSize = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000003;
+    int queries = (argc > 2) ? atoi(argv[2]) : 20;
+
+    unsigned short* seqLens = TestUtil::getSeqLens(dbSize);
+
+    const int maxLevel = QueryScore::getSupportedSimdLevel();
+    std::cout << "Supported instruction set: " << simdNames[maxLevel] << "\n";
+
+    srand(1);
+    int errors = 0;
+    std::vector<double> times(maxLevel + 1, 0.0);
+    std::vector<unsigned int> seqList;
+    for (int q = 0; q < queries; q++){
+        // low z-score thresholds for some queries fill the result list up to MAX_RES_LIST_LEN
+        float zscoreThr = (q % 4 == 3) ? 0.0 : 5.0;
+        QueryScoreGlobal queryScore(dbSize, seqLens, 6, 100, 1e-4, zscoreThr);
+        for (int l = 0; l < 2000; l++){
+            seqList.clear();
+            size_t listSize = rand() % 500;
+            TestUtil::appendRandomSeqList(seqList, listSize, dbSize);
+            queryScore.addScores(&seqList[0], seqList.size(), rand() % 40);
+        }
+        unsigned int identityId = (q % 2 == 0) ? UINT_MAX : rand() % dbSize;
+
+        std::vector<hit_t> reference;
+        for (int level = 0; level <= maxLevel; level++){
+            queryScore.setSimdLevel(level);
+            double start = TestUtil::now();
+            queryScore.setPrefilteringThresholds();
+            std::pair<hit_t *, size_t> res = queryScore.getResult(300, identityId);
+            times[level] += TestUtil::now() - start;
+            if (level == 0){
+                reference.assign(res.first, res.first + res.second);
+                continue;
+            }
+            bool same = (res.second == reference.size());
+            for (size_t i = 0; same && i < res.second; i++)
+                same = (res.first[i].seqId == reference[i].seqId && res.first[i].prefScore == reference[i].prefScore
+                        && res.first[i].zScore == reference[i].zScore);
+            if (!same){
+                std::cout << "Query " << q << ": " << simdNames[level] << " returns " << res.second
+                    << " hits, SSE2 " << reference.size() << " hits\n";
+                errors++;
+            }
+        }
+    }
+    std::cout << "DB size " << dbSize << ", " << queries << " queries\n";
+    for (int level = 0; level <= maxLevel; level++)
+        std::cout << simdNames[level] << ": " << times[level] << " s\n";
+
+    delete[] seqLens;
+    return TestUtil::report(errors);
+}
@@ -0,0 +1,98 @@
+//
+// Compares the results of the sparse reset and result extraction of QueryScoreGlobal and QueryScorePartitioned
+// (only the touched blocks of the score array) with the full score array scan for queries with few to many hits.
+// The score objects are reused for all queries to test the reset.
+//
+// USAGE: TestQueryScoreSparse [DB size] [number of queries]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <climits>
+#include <vector>
+
+#include "../prefiltering/QueryScoreGlobal.h"
+#include "../prefiltering/QueryScorePartitioned.h"
+#include "TestUtil.h"
+
+bool sameResults(std::pair<hit_t *, size_t> res, std::vector<hit_t>& reference){
+    if (res.second != reference.size())
+        return false;
+    for (size_t i = 0; i < res.second; i++){
+        if (res.first[i].seqId != reference[i].seqId || res.first[i].prefScore != reference[i].prefScore)
+            return false;
+    }
+    return true;
+}
+
+int main (int argc, const char * argv[])
+{
+    size_t dbSize = (argc > 1) ? strtoull(argv[1], NULL, 10) : 2000000;
+    int queries = (argc > 2) ? atoi(argv[2]) : 40;
+
+    unsigned short* seqLens = TestUtil::getSeqLens(dbSize);
+
+    QueryScore* dense = new QueryScoreGlobal(dbSize, seqLens, 6, 100, 1e-4, 5.0);
+    dense->setSparseReset(false);
+    QueryScore* sparse = new QueryScoreGlobal(dbSize, seqLens, 6, 100, 1e-4, 5.0);
+    QueryScore* partitioned = new QueryScorePartitioned(dbSize, seqLens, 6, 100, 1e-4, 5.0);
+
+    srand(1);
+    int errors = 0;
+    double timeDense = 0.0;
+    double timeSparse = 0.0;
+    std::vector<unsigned int> seqList;
+    std::vector<hit_t> reference;
+    for (int q = 0; q < queries; q++){
+        // from a few hundred hits up to more hits than the sparse mode tracks
+        size_t hits = 100 << (q % 12);
+        size_t lists = std::max((size_t) 1, hits / 20);
+        const unsigned int identityId = (q % 2 == 0) ? UINT_MAX : rand() % dbSize;
+
+        double start = TestUtil::now();
+        dense->reset();
+        timeDense += TestUtil::now() - start;
+        start = TestUtil::now();
+        sparse->reset();
+        timeSparse += TestUtil::now() - start;
+        partitioned->reset();
+        for (size_t l = 0; l < lists; l++){
+            seqList.clear();
+            TestUtil::appendRandomSeqList(seqList, 40, dbSize);
+            unsigned short score = rand() % 40;
+            dense->addScores(&seqList[0], seqList.size(), score);
+            sparse->addScores(&seqList[0], seqList.size(), score);
+            partitioned->addScores(&seqList[0], seqList.size(), score);
+        }
+        partitioned->flushScores();
+
+        start = TestUtil::now();
+        dense->setPrefilteringThresholds();
+        std::pair<hit_t *, size_t> res = dense->getResult(300, identityId);
+        timeDense += TestUtil::now() - start;
+        reference.assign(res.first, res.first + res.second);
+
+        start = TestUtil::now();
+        sparse->setPrefilteringThresholds();
+        res = sparse->getResult(300, identityId);
+        timeSparse += TestUtil::now() - start;
+        if (!sameResults(res, reference)){
+            std::cout << "Query " << q << " (" << lists * 40 << " hits): sparse QueryScoreGlobal returns " << res.second << " hits instead of " << reference.size() << "\n";
+            errors++;
+        }
+        partitioned->setPrefilteringThresholds();
+        res = partitioned->getResult(300, identityId);
+        if (!sameResults(res, reference)){
+            std::cout << "Query " << q << " (" << lists * 40 << " hits): sparse QueryScorePartitioned returns " << res.second << " hits instead of " << reference.size() << "\n";
+            errors++;
+        }
+    }
+    std::cout << "DB size " << dbSize << ", " << queries << " queries\n";
+    std::cout << "reset, thresholds and result: full array " << timeDense << " s, sparse " << timeSparse << " s\n";
+
+    delete dense;
+    delete sparse;
+    delete partitioned;
+    delete[] seqLens;
+    return TestUtil::report(errors);
+}
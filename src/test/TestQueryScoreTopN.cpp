@@ -0,0 +1,70 @@
+//
+// Compares the bounded selection of the best hits in QueryScore::getResult (maxHits > 0) with the fully sorted result list
+// for queries with many hits and measures the time of getResult for both.
+//
+// USAGE: TestQueryScoreTopN [DB size] [number of queries] [max. hits]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <climits>
+#include <vector>
+
+#include "../prefiltering/QueryScoreGlobal.h"
+#include "TestUtil.h"
+
+int main (int argc, const char * argv[])
+{
+    size_t dbSize = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+    int queries = (argc > 2) ? atoi(argv[2]) : 20;
+    size_t maxHits = (argc > 3) ? strtoull(argv[3], NULL, 10) : 300;
+
+    unsigned short* seqLens = TestUtil::getSeqLens(dbSize);
+
+    srand(1);
+    int errors = 0;
+    size_t hitsSum = 0;
+    double timeFull = 0.0;
+    double timeTopN = 0.0;
+    std::vector<unsigned int> seqList;
+    std::vector<hit_t> reference;
+    for (int q = 0; q < queries; q++){
+        // a low z-score threshold for many hits, few distinct scores for many equal z-scores
+        QueryScoreGlobal queryScore(dbSize, seqLens, 6, 100, 1e-4, (q % 2 == 0) ? 0.0 : 2.0);
+        for (int l = 0; l < 2000; l++){
+            seqList.clear();
+            size_t listSize = rand() % 500;
+            TestUtil::appendRandomSeqList(seqList, listSize, dbSize);
+            queryScore.addScores(&seqList[0], seqList.size(), 10 + rand() % 4);
+        }
+        unsigned int identityId = (q % 4 < 2) ? UINT_MAX : rand() % dbSize;
+        queryScore.setPrefilteringThresholds();
+
+        double start = TestUtil::now();
+        std::pair<hit_t *, size_t> res = queryScore.getResult(300, identityId);
+        timeFull += TestUtil::now() - start;
+        reference.assign(res.first, res.first + std::min(res.second, maxHits));
+        hitsSum += res.second;
+
+        start = TestUtil::now();
+        res = queryScore.getResult(300, identityId, maxHits);
+        timeTopN += TestUtil::now() - start;
+        if (res.second < reference.size()){
+            std::cout << "Query " << q << ": " << res.second << " hits instead of at least " << reference.size() << "\n";
+            errors++;
+            continue;
+        }
+        for (size_t i = 0; i < reference.size(); i++){
+            if (res.first[i].seqId != reference[i].seqId || res.first[i].zScore != reference[i].zScore){
+                std::cout << "Query " << q << ": different hit at position " << i << "\n";
+                errors++;
+                break;
+            }
+        }
+    }
+    std::cout << "DB size " << dbSize << ", " << queries << " queries, " << hitsSum / queries << " hits per query\n";
+    std::cout << "Full sort: " << timeFull << " s, best " << maxHits << " hits: " << timeTopN << " s\n";
+
+    delete[] seqLens;
+    return TestUtil::report(errors);
+}
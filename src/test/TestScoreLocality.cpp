@@ -0,0 +1,146 @@
+//
+// Microbenchmark for the cache locality of the prefiltering score updates.
+// Builds the index table of a database once with the length sorted sequence ids and once with the ids renumbered
+// by Prefiltering::getCacheLocalOrder and adds the scores of the exact k-mer matches of the first query sequences.
+// Reports the number of score array cache lines touched per sequence list entry, the time and,
+// if the kernel allows it, the hardware cache misses.
+//
+// USAGE: TestScoreLocality <ffindexDB> [k] [number of queries]
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "../commons/DBReader.h"
+#include "../commons/SubstitutionMatrix.h"
+#include "../prefiltering/Prefiltering.h"
+#include "../prefiltering/QueryScoreGlobal.h"
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+// returns -1 if the cache miss counter is not available (e.g. perf_event_paranoid)
+int openCacheMissCounter(){
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void run(const char* name, DBReader* tdbr, DBReader* qdbr, Sequence** seqs, int threads, int kmerSize, size_t queries){
+    IndexTable* indexTable = Prefiltering::getIndexTable(tdbr, seqs, threads, 21, kmerSize, 0, tdbr->getSize());
+
+    // score array cache lines (64 byte, 32 scores) touched by the sequence lists with more than one entry
+    size_t lines = 0;
+    size_t entries = 0;
+    for (size_t kmer = 0; kmer < indexTable->tableSize; kmer++){
+        size_t listSize;
+        unsigned int* seqList = indexTable->getDBSeqList(kmer, &listSize);
+        // a single entry always needs one cache line
+        if (listSize < 2)
+            continue;
+        for (size_t i = 0; i < listSize; i++){
+            if (i == 0 || (seqList[i] >> 5) != (seqList[i-1] >> 5))
+                lines++;
+        }
+        entries += listSize;
+    }
+
+    QueryScore* queryScore = new QueryScoreGlobal(tdbr->getSize(), tdbr->getSeqLens(), kmerSize, 0, 1e-5, 50.0);
+    Indexer idxer(21, kmerSize);
+    Sequence* q = seqs[0];
+    int fd = openCacheMissCounter();
+    if (fd >= 0){
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    size_t matches = 0;
+    for (size_t id = 0; id < queries; id++){
+        q->mapSequence(id, qdbr->getDbKey(id), qdbr->getData(id));
+        idxer.reset();
+        while (q->hasNextKmer(kmerSize)){
+            unsigned int kmerIdx = idxer.getNextKmerIndex(q->nextKmer(kmerSize), kmerSize);
+            size_t listSize;
+            unsigned int* seqList = indexTable->getDBSeqList(kmerIdx, &listSize);
+            queryScore->addScores(seqList, listSize, 1);
+            matches += listSize;
+        }
+        queryScore->reset();
+    }
+    gettimeofday(&end, NULL);
+    long long misses = -1;
+    if (fd >= 0){
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &misses, sizeof(misses)) != sizeof(misses))
+            misses = -1;
+        close(fd);
+    }
+    double sec = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1e6;
+
+    std::cout << name << ": " << (double) lines / entries << " score cache lines per list entry (lists with > 1 entry), "
+        << matches << " score updates in " << sec << " s";
+    if (misses >= 0)
+        std::cout << ", " << misses << " cache misses (" << (double) misses / matches << " per update)";
+    else
+        std::cout << ", cache miss counter not available";
+    std::cout << "\n";
+
+    delete queryScore;
+    delete indexTable;
+}
+
+int main (int argc, const char * argv[])
+{
+    if (argc < 2){
+        std::cout << "USAGE: TestScoreLocality <ffindexDB> [k] [number of queries]\n";
+        return EXIT_FAILURE;
+    }
+    Debug::setDebugLevel(Debug::WARNING);
+    std::string db(argv[1]);
+    std::string dbIndex = db + ".index";
+    int kmerSize = (argc > 2) ? atoi(argv[2]) : 6;
+    size_t queries = (argc > 3) ? strtoull(argv[3], NULL, 10) : 1000;
+    int threads = 1;
+#ifdef OPENMP
+    threads = omp_get_max_threads();
+#endif
+
+    SubstitutionMatrix subMat("../../data/blosum62.out", 8.0);
+    Sequence** seqs = new Sequence*[threads];
+    for (int i = 0; i < threads; i++)
+        seqs[i] = new Sequence(50000, subMat.aa2int, subMat.int2aa, Sequence::AMINO_ACIDS);
+
+    DBReader qdbr(db.c_str(), dbIndex.c_str());
+    qdbr.open(DBReader::NOSORT);
+    queries = std::min(queries, qdbr.getSize());
+    DBReader tdbr(db.c_str(), dbIndex.c_str());
+    tdbr.open(DBReader::SORT);
+
+    run("length sorted", &tdbr, &qdbr, seqs, threads, kmerSize, queries);
+    std::vector<size_t> order = Prefiltering::getCacheLocalOrder(&tdbr, seqs, threads, 21, kmerSize);
+    tdbr.setLocalIdOrder(&order[0]);
+    run("renumbered   ", &tdbr, &qdbr, seqs, threads, kmerSize, queries);
+
+    tdbr.close();
+    qdbr.close();
+    for (int i = 0; i < threads; i++)
+        delete seqs[i];
+    delete[] seqs;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,74 @@
+//
+// Round trip test for the compression of the index table sequence lists.
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <cstdio>
+#include <climits>
+#include <algorithm>
+
+#include "SequenceListCodec.h"
+#include "Util.h"
+#include "TestUtil.h"
+
+int main (int argc, const char * argv[])
+{
+    const int maxListSize = 1000;
+    unsigned int* seqList = new unsigned int[maxListSize];
+    unsigned char* encoded = new unsigned char[SequenceListCodec::maxEncodedSize(maxListSize)];
+    unsigned int* decoded = (unsigned int*) Util::mem_align(16, SequenceListCodec::BLOCK_SIZE * sizeof(unsigned int));
+    SequenceListCodec decoder;
+
+    srand(1);
+    int errors = 0;
+    size_t encodedSum = 0;
+    size_t rawSum = 0;
+    // list sizes around the block size, gaps from dense lists up to ids beyond 2^31
+    int listSizes[] = {0, 1, 2, 127, 128, 129, 256, 300, 1000};
+    unsigned long long maxGaps[] = {1, 2, 100, 100000, 1ULL << 24, 1ULL << 32};
+    for (int s = 0; s < 9; s++){
+        for (int g = 0; g < 6; g++){
+            int listSize = listSizes[s];
+            // leave room for listSize ids below UINT_MAX
+            const unsigned long long maxId = UINT_MAX - maxListSize;
+            unsigned long long id = ((unsigned long long) rand() * rand()) % std::min(maxGaps[g], maxId);
+            for (int i = 0; i < listSize; i++){
+                seqList[i] = (unsigned int) id;
+                unsigned long long gap = 1 + ((unsigned long long) rand() * rand()) % maxGaps[g];
+                id += (id + gap <= maxId) ? gap : 1;
+            }
+            size_t encodedSize = SequenceListCodec::encode(seqList, listSize, encoded);
+            encodedSum += encodedSize;
+            rawSum += listSize * sizeof(unsigned int);
+            if (encodedSize != SequenceListCodec::encodedSize(encoded, listSize)){
+                std::cout << "Wrong encoded size for list size " << listSize << " max. gap " << maxGaps[g] << "\n";
+                errors++;
+            }
+
+            decoder.initDecoding(encoded, listSize);
+            int pos = 0;
+            int n;
+            while ((n = decoder.decodeNextBlock(decoded)) > 0){
+                for (int i = 0; i < n; i++){
+                    if (pos + i >= listSize || decoded[i] != seqList[pos + i]){
+                        std::cout << "Wrong id at position " << pos + i << " for list size " << listSize << " max. gap " << maxGaps[g] << "\n";
+                        errors++;
+                        break;
+                    }
+                }
+                pos += n;
+            }
+            if (pos != listSize){
+                std::cout << "Decoded " << pos << " ids instead of " << listSize << "\n";
+                errors++;
+            }
+        }
+    }
+    std::cout << "Raw size: " << rawSum << " byte, encoded size: " << encodedSum << " byte\n";
+
+    delete[] seqList;
+    delete[] encoded;
+    free(decoded);
+    return TestUtil::report(errors);
+}
@@ -0,0 +1,70 @@
+//
+// Passes numbered items from a producer thread to a consumer thread through a small SpscQueue:
+// all items have to arrive exactly once and in order, and a full queue has to reject items.
+//
+// USAGE: TestSpscQueue [number of items] [queue capacity]
+//
+
+#include <iostream>
+#include <cstdlib>
+
+#include "SpscQueue.h"
+#include "TestUtil.h"
+
+int main (int argc, const char * argv[])
+{
+    size_t items = (argc > 1) ? strtoull(argv[1], NULL, 10) : 1000000;
+    size_t capacity = (argc > 2) ? strtoull(argv[2], NULL, 10) : 16;
+    int errors = 0;
+
+    // single thread: the queue holds exactly capacity items
+    SpscQueue<size_t> bounded(capacity);
+    for (size_t i = 0; i < capacity; i++)
+        if (!bounded.push(i)){
+            std::cout << "The queue rejected item " << i << " before it was full\n";
+            errors++;
+        }
+    if (bounded.push(capacity)){
+        std::cout << "The full queue accepted an item\n";
+        errors++;
+    }
+    size_t item;
+    for (size_t i = 0; i < capacity; i++)
+        if (!bounded.pop(&item) || item != i){
+            std::cout << "Wrong item " << item << " instead of " << i << "\n";
+            errors++;
+        }
+    if (bounded.pop(&item)){
+        std::cout << "The empty queue returned an item\n";
+        errors++;
+    }
+
+    // producer and consumer thread
+    SpscQueue<size_t> queue(capacity);
+    size_t received = 0;
+    size_t outOfOrder = 0;
+#pragma omp parallel sections num_threads(2)
+    {
+#pragma omp section
+        {
+            for (size_t i = 1; i <= items; i++)
+                queue.waitPush(i);
+            queue.waitPush(0);
+        }
+#pragma omp section
+        {
+            size_t next = 1;
+            for (queue.waitPop(&item); item != 0; queue.waitPop(&item)){
+                if (item != next)
+                    outOfOrder++;
+                next = item + 1;
+                received++;
+            }
+        }
+    }
+    std::cout << received << " of " << items << " items received through a queue of " << capacity << " items, "
+        << outOfOrder << " out of order\n";
+    if (received != items || outOfOrder > 0)
+        errors++;
+    return TestUtil::report(errors);
+}
@@ -0,0 +1,52 @@
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+//
+// Helpers shared by the test programs: wall clock timing, the random target sequence fixtures of the score tests
+// and the error report at the end of a test.
+//
+
+#include <iostream>
+#include <cstdlib>
+#include <vector>
+#include <sys/time.h>
+
+class TestUtil {
+
+    public:
+
+        // wall clock time in seconds
+        static double now(){
+            struct timeval t;
+            gettimeofday(&t, NULL);
+            return t.tv_sec + t.tv_usec / 1e6;
+        }
+
+        // target sequence lengths decreasing from 1000 to 50, the order of a DBReader opened with DBReader::SORT
+        // (new[], freed by the caller)
+        static unsigned short* getSeqLens(size_t dbSize){
+            unsigned short* seqLens = new unsigned short[dbSize];
+            for (size_t i = 0; i < dbSize; i++)
+                seqLens[i] = 1000 - (unsigned short) (i * 950 / dbSize);
+            return seqLens;
+        }
+
+        // random target sequence id, also for databases with more than RAND_MAX sequences
+        static unsigned int getRandomSeqId(size_t dbSize){
+            return ((size_t) rand() * RAND_MAX + rand()) % dbSize;
+        }
+
+        // appends listSize random target sequence ids (unsorted)
+        static void appendRandomSeqList(std::vector<unsigned int>& seqList, size_t listSize, size_t dbSize){
+            for (size_t i = 0; i < listSize; i++)
+                seqList.push_back(getRandomSeqId(dbSize));
+        }
+
+        // prints the number of errors and returns the exit code of the test
+        static int report(int errors){
+            std::cout << errors << " errors\n";
+            return errors > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+        }
+};
+
+#endif
@@ -0,0 +1,284 @@
+#include <iostream>
+#include <unistd.h>
+#include <string>
+#include <time.h>
+#include <sys/time.h>
+
+#include "../prefiltering/Prefiltering.h"
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+void printUsage(){
+
+    std::string usage("\nPrecomputes the prefiltering index table of the target database and writes it into a file.\n");
+    usage.append("The file can be passed to mmseqs_pref with --index, it is mapped read-only into the memory and shared between processes on the same machine.\n");
+    usage.append("The parameters have to be the same as in the prefiltering run.\n\n");
+    usage.append("USAGE: mmseqs_createindex <targetDB> <outIndexFile> [opts]\n"
+            "-k              \t[int]\tk-mer size in the range [4:7] (default=6).\n"
+            "-cpu            \t[int]\tNumber of cores used for the computation (default=all cores).\n"
+            "--alph-size     \t[int]\tAmino acid alphabet size (default=21).\n"
+            "--max-seq-len   \t[int]\tMaximum sequence length (default=50000).\n"
+            "--nucl          \t\tNucleotide sequences input.\n"
+            "--skip          \t[int]\tNumber of skipped k-mers during the index table generation.\n"
+            "--compress      \t\tStore the sequence lists compressed (smaller file and memory footprint).\n"
+            "--single-pass   \t\tMap the target sequences only once (faster, needs more memory).\n"
+            "--spaced-seed   \t[str]\tSpaced k-mer pattern, e.g. 1101011 ('1': k-mer position). Sets k to the number of '1' positions.\n"
+            "--max-kmer-occ  \t[int]\tRemove k-mers occurring in more than the given number of target sequences from the index table (default=0: no limit).\n"
+            "--reorder-db    \t\tRenumber the target sequences by k-mer content for cache-local score updates (faster for large databases).\n"
+            "--sub-mat       \t[file]\tAmino acid substitution matrix file.\n"
+            "-v              \t[int]\tVerbosity level: 0=NOTHING, 1=ERROR, 2=WARNING, 3=INFO (default=3).\n");
+    Debug(Debug::INFO) << usage;
+}
+
+void parseArgs(int argc, const char** argv, std::string* targetDB, std::string* indexFile, std::string* scoringMatrixFile, int* kmerSize, int* alphabetSize, size_t* maxSeqLen, int* seqType, int* skip, int* threads, int* verbosity, bool* compress, bool* singlePass, std::string* spacedSeed, unsigned int* maxKmerOcc, bool* reorderDB){
+    if (argc < 3){
+        printUsage();
+        exit(EXIT_FAILURE);
+    }
+
+    targetDB->assign(argv[1]);
+    indexFile->assign(argv[2]);
+
+    int i = 3;
+    while (i < argc){
+        if (strcmp(argv[i], "--sub-mat") == 0){
+            if (*seqType == Sequence::NUCLEOTIDES){
+                Debug(Debug::ERROR) << "No scoring matrix is allowed for nucleotide sequences.\n";
+                exit(EXIT_FAILURE);
+            }
+            if (++i < argc){
+                scoringMatrixFile->assign(argv[i]);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "-k") == 0){
+            if (++i < argc){
+                *kmerSize = atoi(argv[i]);
+                if (*kmerSize < 4 || *kmerSize > 7){
+                    Debug(Debug::ERROR) << "Please choose k in the range [4:7].\n";
+                    exit(EXIT_FAILURE);
+                }
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--alph-size") == 0){
+            if (++i < argc){
+                *alphabetSize = atoi(argv[i]);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--max-seq-len") == 0){
+            if (++i < argc){
+                *maxSeqLen = atoi(argv[i]);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--nucl") == 0){
+            *seqType = Sequence::NUCLEOTIDES;
+            i++;
+        }
+        else if (strcmp(argv[i], "--reorder-db") == 0){
+            *reorderDB = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--max-kmer-occ") == 0){
+            if (++i < argc){
+                *maxKmerOcc = strtoul(argv[i], NULL, 10);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--spaced-seed") == 0){
+            if (++i < argc){
+                spacedSeed->assign(argv[i]);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--single-pass") == 0){
+            *singlePass = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--compress") == 0){
+            *compress = true;
+            i++;
+        }
+        else if (strcmp(argv[i], "--skip") == 0){
+            if (++i < argc){
+                *skip = atoi(argv[i]);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "-cpu") == 0){
+            if (++i < argc){
+                *threads = atoi(argv[i]);
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "-v") == 0){
+            if (++i < argc){
+                *verbosity = atoi(argv[i]);
+                if (*verbosity < 0 || *verbosity > 3){
+                    Debug(Debug::ERROR) << "Wrong value for verbosity, please choose one in the range [0:3].\n";
+                    exit(1);
+                }
+                i++;
+            }
+            else {
+                printUsage();
+                Debug(Debug::ERROR) << "No value provided for " << argv[i-1] << "\n";
+                exit(EXIT_FAILURE);
+            }
+        }
+        else {
+            printUsage();
+            Debug(Debug::ERROR) << "Wrong argument: " << argv[i] << "\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+}
+
+int main (int argc, const char * argv[])
+{
+    int verbosity = Debug::INFO;
+
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+
+    int kmerSize =  6;
+    int alphabetSize = 21;
+    size_t maxSeqLen = 50000;
+    int skip = 0;
+    int seqType = Sequence::AMINO_ACIDS;
+    bool compress = false;
+    bool singlePass = false;
+    std::string spacedSeed = "";
+    unsigned int maxKmerOcc = 0;
+    bool reorderDB = false;
+    int threads = 1;
+#ifdef OPENMP
+    threads = omp_get_max_threads();
+#endif
+
+    std::string targetDB = "";
+    std::string indexFile = "";
+    // get the path of the scoring matrix
+    char* mmdir = getenv ("MMDIR");
+    if (mmdir == 0){
+        std::cerr << "Please set the environment variable $MMDIR to your MMSEQS installation directory.\n";
+        exit(1);
+    }
+    std::string scoringMatrixFile(mmdir);
+    scoringMatrixFile = scoringMatrixFile + "/data/blosum62.out";
+
+    parseArgs(argc, argv, &targetDB, &indexFile, &scoringMatrixFile, &kmerSize, &alphabetSize, &maxSeqLen, &seqType, &skip, &threads, &verbosity, &compress, &singlePass, &spacedSeed, &maxKmerOcc, &reorderDB);
+    Debug::setDebugLevel(verbosity);
+#ifdef OPENMP
+    omp_set_num_threads(threads);
+    Debug(Debug::INFO) << "Using " << threads << " threads.\n";
+#endif
+
+    if (seqType == Sequence::NUCLEOTIDES)
+        alphabetSize = 5;
+
+    if (spacedSeed.length() > 0){
+        int weight = Indexer::getSpacedSeedWeight(spacedSeed);
+        if (weight < 4 || weight > 7 || spacedSeed.length() > IndexTable::MAX_SPACED_SEED_LEN){
+            Debug(Debug::ERROR) << "Invalid spaced seed " << spacedSeed << ". Please use a pattern of '0' and '1' with 4 to 7 '1' positions, "
+                << "starting and ending with '1' and at most " << IndexTable::MAX_SPACED_SEED_LEN << " characters long.\n";
+            exit(EXIT_FAILURE);
+        }
+        kmerSize = weight;
+    }
+
+    Debug(Debug::WARNING) << "k-mer size: " << kmerSize << "\n";
+    if (spacedSeed.length() > 0)
+        Debug(Debug::WARNING) << "Spaced seed: " << spacedSeed << "\n";
+    if (maxKmerOcc > 0)
+        Debug(Debug::WARNING) << "Max. k-mer occurrence: " << maxKmerOcc << "\n";
+    Debug(Debug::WARNING) << "Alphabet size: " << alphabetSize << "\n";
+    Debug(Debug::WARNING) << "Skip: " << skip << "\n\n";
+
+    BaseMatrix* subMat;
+    if (seqType == Sequence::AMINO_ACIDS)
+        subMat = Prefiltering::getSubstitutionMatrix(scoringMatrixFile, alphabetSize, 8.0);
+    else
+        subMat = new NucleotideMatrix();
+
+    std::string targetDBIndex = targetDB + ".index";
+    // the prefiltering uses the local ids of the sequences sorted by length
+    DBReader* tdbr = new DBReader(targetDB.c_str(), targetDBIndex.c_str());
+    tdbr->open(DBReader::SORT);
+    Debug(Debug::INFO) << "Target database: " << targetDB << "(size=" << tdbr->getSize() << ")\n";
+
+    Sequence** seqs = new Sequence*[threads];
+    for (int i = 0; i < threads; i++)
+        seqs[i] = new Sequence(maxSeqLen, subMat->aa2int, subMat->int2aa, seqType);
+    std::vector<size_t> order;
+    if (reorderDB){
+        Debug(Debug::INFO) << "Renumbering the target sequences...\n";
+        order = Prefiltering::getCacheLocalOrder(tdbr, seqs, threads, alphabetSize, kmerSize, spacedSeed);
+        tdbr->setLocalIdOrder(&order[0]);
+    }
+    IndexTable* indexTable = Prefiltering::getIndexTable(tdbr, seqs, threads, alphabetSize, kmerSize, 0, tdbr->getSize(), skip, compress, singlePass, spacedSeed, maxKmerOcc);
+    if (reorderDB)
+        indexTable->setSeqOrder(order);
+    for (int i = 0; i < threads; i++)
+        delete seqs[i];
+    delete[] seqs;
+    indexTable->printKmerStatistics(subMat->int2aa);
+
+    Debug(Debug::INFO) << "Writing the index table to " << indexFile << "...\n";
+    indexTable->writeToFile(indexFile.c_str(), Prefiltering::getMatrixHash(subMat), Prefiltering::getDBHash(tdbr), tdbr->getSize());
+    delete indexTable;
+
+    tdbr->close();
+    delete tdbr;
+    delete subMat;
+
+    gettimeofday(&end, NULL);
+    int sec = end.tv_sec - start.tv_sec;
+    Debug(Debug::WARNING) << "Time for the index table creation: " << (sec / 3600) << " h " << (sec % 3600 / 60) << " m " << (sec % 60) << "s\n";
+
+    return 0;
+}
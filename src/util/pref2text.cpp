@@ -0,0 +1,64 @@
+#include "../commons/DBReader.h"
+#include "../commons/DBWriter.h"
+#include "../commons/Debug.h"
+#include "../commons/OutputBuffer.h"
+#include "../commons/PrefilterResultReader.h"
+
+void printUsage(){
+    std::string usage("\nConverts prefiltering results in the binary format (mmseqs_pref --binary-output) into the text format.\n");
+    usage.append("Result lists in the text format are copied.\n\n");
+    usage.append("USAGE: <targetDB> <prefResultsDB> <outDB>\n");
+    Debug(Debug::ERROR) << usage;
+}
+
+void parseArgs(int argc, const char** argv,
+               std::string* targetDB,
+               std::string* prefDB,
+               std::string* outDB){
+    if (argc < 4){
+        printUsage();
+        exit(EXIT_FAILURE);
+    }
+    targetDB->assign(argv[1]);
+    prefDB->assign(argv[2]);
+    outDB->assign(argv[3]);
+}
+
+int main (int argc, const char * argv[])
+{
+    std::string targetDB = "";
+    std::string prefDB = "";
+    std::string outDB = "";
+
+    parseArgs(argc, argv, &targetDB, &prefDB, &outDB);
+    // the target ids of the binary records are the ids in the NOSORT order
+    DBReader tdbr(targetDB.c_str(), std::string(targetDB + ".index").c_str());
+    tdbr.open(DBReader::NOSORT);
+    DBReader prefdbr(prefDB.c_str(), std::string(prefDB + ".index").c_str());
+    prefdbr.open(DBReader::NOSORT);
+    DBWriter dbw(outDB.c_str(), std::string(outDB + ".index").c_str());
+    dbw.open();
+
+    Debug(Debug::WARNING) << "Converting " << prefdbr.getSize() << " result lists to " << outDB << "\n";
+    PrefilterResultReader reader(&tdbr);
+    OutputBuffer out;
+    for (size_t i = 0; i < prefdbr.getSize(); i++){
+        out.clear();
+        reader.init(prefdbr.getData(i), prefdbr.getDataSize(i));
+        // the same formatting as the text output of the prefiltering
+        while (reader.next()){
+            out.appendString(reader.getTargetKey());
+            out.appendChar('\t');
+            out.appendFloat(reader.getZscore());
+            out.appendChar('\t');
+            out.appendUInt(reader.getPrefScore());
+            out.appendChar('\n');
+        }
+        dbw.write(out.getData(), out.getLength(), prefdbr.getDbKey(i));
+    }
+
+    dbw.close();
+    prefdbr.close();
+    tdbr.close();
+    return EXIT_SUCCESS;
+}
@@ -298,8 +298,7 @@ void mergeClusteringResults(std::string seqDB, std::string outDB, std::list<std:
     DBWriter* dbw = new DBWriter(outDB.c_str(), outDBIndex.c_str());
     dbw->open();
 
-    size_t BUFFER_SIZE = 1000000;
-    char* outBuffer = new char[BUFFER_SIZE];
+    OutputBuffer res;
     // go through all sequences in the database
     for (unsigned int i = 0; i < dbr->getSize(); i++){
 
@@ -310,23 +309,15 @@ void mergeClusteringResults(std::string seqDB, std::string outDB, std::list<std:
         // representative
         char* dbKey = dbr->getDbKey(i);
 
-        std::stringstream res;
+        res.clear();
         for(std::list<int>::iterator it = mergedClustering[i]->begin(); it != mergedClustering[i]->end(); ++it){
-            res << dbr->getDbKey(*it) << "\n";
+            res.appendString(dbr->getDbKey(*it));
+            res.appendChar('\n');
         }
 
-        std::string cluResultsOutString = res.str();
-        const char* cluResultsOutData = cluResultsOutString.c_str();
-        if (BUFFER_SIZE < strlen(cluResultsOutData)){
-            std::cerr << "Tried to process the clustering list for the query " << dbKey << " , the length of the list = " << mergedClustering[i]->size() << "\n";
-            std::cerr << "Output buffer size < clustering result size! (" << BUFFER_SIZE << " < " << cluResultsOutString.length() << ")\nIncrease buffer size or reconsider your parameters -> output buffer is already huge ;-)\n";
-            continue;
-        }
-        memcpy(outBuffer, cluResultsOutData, cluResultsOutString.length()*sizeof(char));
-        dbw->write(outBuffer, cluResultsOutString.length(), dbKey);
+        dbw->write(res.getData(), res.getLength(), dbKey);
     }
     dbw->close();
-    delete[] outBuffer;
 
     // delete the clustering data structure
     for (unsigned int i = 0; i < dbr->getSize(); i++){
@@ -347,8 +347,7 @@ void writeResults(cluster_t* clusters, char** rep2cluName, DBReader* seqDbr, int
     DBWriter* dbw = new DBWriter(outDB.c_str(), (outDB + ".index").c_str());
     dbw->open();
 
-    size_t BUFFER_SIZE = 1000000;
-    char* outBuffer = new char[BUFFER_SIZE];
+    OutputBuffer res;
 
     for (int i = 0; i < seqDbSize; i++){
         // check if sequence i is a representative
@@ -357,21 +356,14 @@ void writeResults(cluster_t* clusters, char** rep2cluName, DBReader* seqDbr, int
 
         // get the cluster name
         char* cluName = rep2cluName[i];
-        std::stringstream res;
+        res.clear();
         clu_entry_t* e = clusters[i].first;
         while (e != 0){
-            res << seqDbr->getDbKey(e->id) << "\n";
+            res.appendString(seqDbr->getDbKey(e->id));
+            res.appendChar('\n');
             e = e->next;
         }
-        std::string cluResultsOutString = res.str();
-        const char* cluResultsOutData = cluResultsOutString.c_str();
-        if (BUFFER_SIZE < strlen(cluResultsOutData)){
-            std::cerr << "Tried to process the clustering list for the cluster " << cluName << " , length of the list = " << clusters[i].clu_size << "\n";
-            std::cerr << "Output buffer size < clustering result size! (" << BUFFER_SIZE << " < " << cluResultsOutString.length() << ")\nIncrease buffer size or reconsider your parameters -> output buffer is already huge ;-)\n";
-            continue;
-        }
-        memcpy(outBuffer, cluResultsOutData, cluResultsOutString.length()*sizeof(char));
-        dbw->write(outBuffer, cluResultsOutString.length(), cluName);
+        dbw->write(res.getData(), res.getLength(), cluName);
     }
 
     dbw->close();